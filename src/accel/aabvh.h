@@ -26,11 +26,60 @@
 #pragma once
 
 #include "bbox.h"
+#include "ray.h"
 
-#include <stack>
-
-// maximum leaf size
+// default maximum leaf size
 static const uint LEAF_SIZE = 8;
+// bound on tree depth; sizes the fixed traversal stack.
+// Median splits give a depth of at most log2(N).  SAH splits can
+// be lopsided, so past half this depth the builder falls back to
+// median splits, which keeps every tree within the bound.
+static const uint AABVH_MAX_DEPTH = 64;
+
+// how an AABVH is built
+struct AABVHOptions
+{
+    enum Strategy {
+        MEDIAN_SPLIT,   // split at the median, cycling through the axes
+        BINNED_SAH      // split where the surface area heuristic,
+                        // evaluated at evenly spaced bins, is least
+    };
+    Strategy    strategy;
+    uint        leafSize;   // maximum number of primitives in a leaf
+    uint        numBins;    // candidate split planes per axis (SAH only)
+    AABVHOptions() :
+        strategy(MEDIAN_SPLIT),
+        leafSize(LEAF_SIZE),
+        numBins(16)
+    {}
+};
+
+// does the ray (p + t*r, t >= 0) pass through the box?
+// The box is padded very slightly, so that the test errs on the side
+// of reporting a hit when the ray grazes the boundary.
+inline bool hasIsct(const BBox3d &bbox, const Ray3d &ray)
+{
+    double tnear = 0.0;
+    double tfar  = DBL_MAX;
+    for(uint d=0; d<3; d++) {
+        double pad = 1.0e-10 * (fabs(bbox.minp[d]) + fabs(bbox.maxp[d]));
+        double lo  = bbox.minp[d] - pad;
+        double hi  = bbox.maxp[d] + pad;
+        if(ray.r[d] == 0.0) {
+            if(ray.p[d] < lo || ray.p[d] > hi)
+                return false;
+            continue;
+        }
+        double t0 = (lo - ray.p[d]) / ray.r[d];
+        double t1 = (hi - ray.p[d]) / ray.r[d];
+        if(t0 > t1)     std::swap(t0, t1);
+        tnear = std::max(tnear, t0);
+        tfar  = std::min(tfar, t1);
+        if(tnear > tfar)
+            return false;
+    }
+    return true;
+}
 
 template<class GeomIdx>
 struct GeomBlob
@@ -40,112 +89,374 @@ struct GeomBlob
     GeomIdx id;
 };
 
-template<class GeomIdx>
+// Nodes are stored in a single array in depth-first order, so the
+// left child of an interior node is always the next node and only the
+// right child's index is stored.  A leaf refers to a contiguous range
+// of the primitive arrays, which are sorted into leaf order.
 struct AABVHNode
 {
-    BBox3d                          bbox;
-    AABVHNode                       *left;
-    AABVHNode                       *right;
-    ShortVec<uint, LEAF_SIZE>       blobids;
-    inline bool isLeaf() const { return left == nullptr; }
+    BBox3d  bbox;
+    uint    offset;     // leaf: first primitive; interior: right child
+    uint    count;      // leaf: number of primitives; interior: 0
+    uint    padding[2]; // round up to 64 bytes
+    inline bool isLeaf() const { return count > 0; }
+};
+static_assert(sizeof(AABVHNode) == 64,
+              "AABVHNode should fill exactly one cache line");
+
+// a node from each of two hierarchies; see AABVH::splitPairs()
+struct AABVHNodePair
+{
+    uint lhs, rhs;
+    AABVHNodePair() {}
+    AABVHNodePair(uint l, uint r) : lhs(l), rhs(r) {}
 };
 
 template<class GeomIdx>
 class AABVH
 {
+    template<class OtherIdx> friend class AABVH;
 public:
-    AABVH(const std::vector< GeomBlob<GeomIdx> > &geoms) :
-        root(nullptr), blobs(geoms), tmpids(geoms.size())
+    AABVH(const std::vector< GeomBlob<GeomIdx> > &geoms,
+          const AABVHOptions &opts = AABVHOptions()) :
+        options(opts)
     {
-        ENSURE(blobs.size() > 0);
+        ENSURE(geoms.size() > 0);
+        ENSURE(options.leafSize > 0);
+        ENSURE(options.numBins > 1);
         
+        std::vector<uint> tmpids(geoms.size());
         for(uint k=0; k<tmpids.size(); k++)
             tmpids[k] = k;
         
-        root = constructTree(0, tmpids.size(), 2);
+        nodes.reserve(2 * (geoms.size() / options.leafSize + 1));
+        constructTree(geoms, tmpids, 0, tmpids.size(), 2, 0);
+        
+        // store the primitives in leaf order
+        prim_boxes.resize(geoms.size());
+        prim_ids.resize(geoms.size());
+        for(uint k=0; k<tmpids.size(); k++) {
+            prim_boxes[k]   = geoms[tmpids[k]].bbox;
+            prim_ids[k]     = geoms[tmpids[k]].id;
+        }
     }
     ~AABVH() {}
     
-    // query?
+    // invokes action(idx) for each piece of geometry
+    // whose bounding box overlaps the given box
+    template<class Visitor>
     inline void for_each_in_box(
-        const BBox3d                        &bbox,
-        std::function<void(GeomIdx idx)>    action
-    ) {
-        // do a recursive search and invoke the action at each
-        // piece of geometry
-        std::stack< AABVHNode<GeomIdx>* >  nodes;
-        nodes.push(root);
+        const BBox3d    &bbox,
+        Visitor         action
+    ) const {
+        uint stack[AABVH_MAX_DEPTH+1];
+        uint top = 0;
+        stack[top++] = 0;
         
-        while(!nodes.empty()) {
-            AABVHNode<GeomIdx> *node    = nodes.top();
-                                        nodes.pop();
+        while(top > 0) {
+            uint ni = stack[--top];
+            const AABVHNode &node = nodes[ni];
             
             // check bounding box isct
-            if(!hasIsct(node->bbox, bbox))  continue;
+            if(!hasIsct(node.bbox, bbox))   continue;
             
             // otherwise...
-            if(node->isLeaf()) {
-                for(uint bid : node->blobids) {
-                    if(hasIsct(bbox, blobs[bid].bbox))
-                        action(blobs[bid].id);
+            if(node.isLeaf()) {
+                for(uint k=node.offset; k<node.offset+node.count; k++) {
+                    if(hasIsct(bbox, prim_boxes[k]))
+                        action(prim_ids[k]);
+                }
+            } else {
+                stack[top++] = ni+1;
+                stack[top++] = node.offset;
+            }
+        }
+    }
+    
+    // invokes action(idx) for each piece of geometry
+    // whose bounding box the ray passes through
+    template<class Visitor>
+    inline void for_each_in_ray(
+        const Ray3d     &ray,
+        Visitor         action
+    ) const {
+        uint stack[AABVH_MAX_DEPTH+1];
+        uint top = 0;
+        stack[top++] = 0;
+        
+        while(top > 0) {
+            uint ni = stack[--top];
+            const AABVHNode &node = nodes[ni];
+            
+            if(!hasIsct(node.bbox, ray))    continue;
+            
+            if(node.isLeaf()) {
+                for(uint k=node.offset; k<node.offset+node.count; k++) {
+                    if(hasIsct(prim_boxes[k], ray))
+                        action(prim_ids[k]);
+                }
+            } else {
+                stack[top++] = ni+1;
+                stack[top++] = node.offset;
+            }
+        }
+    }
+    
+    // Simultaneously descend this hierarchy and another, and invoke
+    // action(idx, other_idx) for each pair of geometry whose bounding
+    // boxes overlap.  Whole subtrees of pairs are pruned at once, and
+    // pairs from the same pair of leaves are reported together.
+    // The traversal can be restricted to the subtrees below one pair
+    // of nodes, such as those produced by splitPairs()
+    template<class OtherIdx, class Visitor>
+    inline void for_each_overlapping_pair(
+        const AABVH<OtherIdx>   &other,
+        Visitor                 action,
+        AABVHNodePair           start = AABVHNodePair(0,0)
+    ) const {
+        AABVHNodePair stack[2*AABVH_MAX_DEPTH+1];
+        uint top = 0;
+        stack[top++] = start;
+        
+        while(top > 0) {
+            AABVHNodePair np = stack[--top];
+            const AABVHNode &lnode = nodes[np.lhs];
+            const AABVHNode &rnode = other.nodes[np.rhs];
+            
+            if(!hasIsct(lnode.bbox, rnode.bbox))    continue;
+            
+            if(lnode.isLeaf() && rnode.isLeaf()) {
+                uint lend = lnode.offset + lnode.count;
+                uint rend = rnode.offset + rnode.count;
+                for(uint i=lnode.offset; i<lend; i++) {
+                    const BBox3d &lbox = prim_boxes[i];
+                    if(!hasIsct(lbox, rnode.bbox))  continue;
+                    for(uint j=rnode.offset; j<rend; j++) {
+                        if(hasIsct(lbox, other.prim_boxes[j]))
+                            action(prim_ids[i], other.prim_ids[j]);
+                    }
                 }
+            } else if(descendLeft(lnode, rnode)) {
+                stack[top++] = AABVHNodePair(lnode.offset, np.rhs);
+                stack[top++] = AABVHNodePair(np.lhs+1, np.rhs);
+            } else {
+                stack[top++] = AABVHNodePair(np.lhs, rnode.offset);
+                stack[top++] = AABVHNodePair(np.lhs, np.rhs+1);
+            }
+        }
+    }
+    
+    // Expand the pair of root nodes breadth first, discarding pairs
+    // whose boxes don't overlap, until there are at least minPairs
+    // node pairs or nothing is left to expand.  The subtrees below the
+    // resulting pairs together hold every overlapping pair exactly
+    // once, so they can be traversed independently (e.g. in parallel).
+    // The result only depends on the two hierarchies and minPairs.
+    template<class OtherIdx>
+    void splitPairs(
+        const AABVH<OtherIdx>           &other,
+        uint                            minPairs,
+        std::vector<AABVHNodePair>      *pairs
+    ) const {
+        pairs->clear();
+        std::vector<AABVHNodePair> queue;
+        if(hasIsct(nodes[0].bbox, other.nodes[0].bbox))
+            queue.push_back(AABVHNodePair(0,0));
+        
+        uint front = 0;
+        while(front < queue.size() &&
+              pairs->size() + queue.size() - front < minPairs) {
+            AABVHNodePair np = queue[front++];
+            const AABVHNode &lnode = nodes[np.lhs];
+            const AABVHNode &rnode = other.nodes[np.rhs];
+            
+            AABVHNodePair children[2];
+            if(lnode.isLeaf() && rnode.isLeaf()) {
+                pairs->push_back(np);
+                continue;
+            } else if(descendLeft(lnode, rnode)) {
+                children[0] = AABVHNodePair(np.lhs+1, np.rhs);
+                children[1] = AABVHNodePair(lnode.offset, np.rhs);
             } else {
-                nodes.push(node->left);
-                nodes.push(node->right);
+                children[0] = AABVHNodePair(np.lhs, np.rhs+1);
+                children[1] = AABVHNodePair(np.lhs, rnode.offset);
+            }
+            for(const AABVHNodePair &child : children) {
+                if(hasIsct(nodes[child.lhs].bbox,
+                           other.nodes[child.rhs].bbox))
+                    queue.push_back(child);
             }
         }
+        pairs->insert(pairs->end(), queue.begin() + front, queue.end());
+    }
+    
+    inline uint numNodes() const { return nodes.size(); }
+    
+private:
+    // in a simultaneous traversal, split the larger of the two
+    // nodes unless it is a leaf
+    static inline bool descendLeft(
+        const AABVHNode &lnode, const AABVHNode &rnode
+    ) {
+        if(rnode.isLeaf())  return true;
+        if(lnode.isLeaf())  return false;
+        return surfaceArea(lnode.bbox) >= surfaceArea(rnode.bbox);
     }
     
 private:
     // process range of tmpids including begin, excluding end
     // last_dim provides a hint by saying which dimension a
-    // split was last made along
-    AABVHNode<GeomIdx>* constructTree(uint begin, uint end, uint last_dim)
-    {
+    // split was last made along.  Returns the index of the new node
+    uint constructTree(
+        const std::vector< GeomBlob<GeomIdx> > &geoms,
+        std::vector<uint> &tmpids,
+        uint begin, uint end, uint last_dim, uint depth
+    ) {
         ENSURE(end - begin > 0); // don't tell me to build a tree from nothing
+        ENSURE(depth < AABVH_MAX_DEPTH);
+        uint ni = nodes.size();
+        nodes.push_back(AABVHNode());
         // base case
-        if(end-begin <= LEAF_SIZE) {
-            AABVHNode<GeomIdx> *node = node_pool.alloc();
-            node->left = nullptr;
-            node->blobids.resize(end-begin);
-            for(uint k=0; k<end-begin; k++) {
-                uint blobid = node->blobids[k] = tmpids[begin + k];
-                node->bbox = convex(node->bbox, blobs[blobid].bbox);
-            }
-            return node;
+        if(end-begin <= options.leafSize) {
+            BBox3d bbox;
+            for(uint k=begin; k<end; k++)
+                bbox = convex(bbox, geoms[tmpids[k]].bbox);
+            nodes[ni].bbox      = bbox;
+            nodes[ni].offset    = begin;
+            nodes[ni].count     = end-begin;
+            return ni;
         }
         // otherwise, let's try to split this geometry up
         
         uint dim = (last_dim+1)%3;
-        uint mid = (begin + end) / 2;
-        quickSelect(mid, begin, end, dim);
+        uint mid = begin;
+        if(options.strategy == AABVHOptions::BINNED_SAH &&
+           depth < AABVH_MAX_DEPTH/2)
+            mid = sahPartition(geoms, tmpids, begin, end, &dim);
+        if(mid == begin) { // median split, or no useful SAH split found
+            dim = (last_dim+1)%3;
+            mid = (begin + end) / 2;
+            quickSelect(geoms, tmpids, mid, begin, end, dim);
+        }
         
-        // now recurse
-        AABVHNode<GeomIdx> *node = node_pool.alloc();
-        node->left = constructTree(begin, mid, dim);
-        node->right = constructTree(mid, end, dim);
-        node->bbox = convex(node->left->bbox, node->right->bbox);
-        return node;
+        // now recurse; the left child lands right after this node
+        constructTree(geoms, tmpids, begin, mid, dim, depth+1);
+        uint right = constructTree(geoms, tmpids, mid, end, dim, depth+1);
+        nodes[ni].bbox      = convex(nodes[ni+1].bbox, nodes[right].bbox);
+        nodes[ni].offset    = right;
+        nodes[ni].count     = 0;
+        return ni;
     }
     
-    // precondition: begin <= select < end
-    void quickSelect(uint select, uint begin, uint end, uint dim)
+    // Evaluate the surface area heuristic at numBins-1 evenly spaced
+    // planes along each axis of the representative points' bounds,
+    // and partition [begin,end) at the cheapest one.
+    // Returns the first index of the right half and sets *dim to the
+    // split axis, or returns begin if no plane separates the points.
+    uint sahPartition(
+        const std::vector< GeomBlob<GeomIdx> > &geoms,
+        std::vector<uint> &tmpids,
+        uint begin, uint end, uint *dim
+    ) {
+        BBox3d centers;
+        for(uint k=begin; k<end; k++) {
+            Vec3d p = geoms[tmpids[k]].point;
+            centers = convex(centers, BBox3d(p, p));
+        }
+        
+        uint nBins = options.numBins;
+        std::vector<BBox3d> bin_boxes(nBins);
+        std::vector<uint>   bin_counts(nBins);
+        std::vector<double> right_area(nBins);
+        std::vector<uint>   right_count(nBins);
+        
+        double  best_cost   = DBL_MAX;
+        uint    best_dim    = 0;
+        uint    best_bin    = 0; // split before this bin
+        for(uint d=0; d<3; d++) {
+            double lo       = centers.minp[d];
+            double extent   = centers.maxp[d] - lo;
+            if(!(extent > 0.0))     continue;
+            double scale    = nBins / extent;
+            
+            for(uint b=0; b<nBins; b++) {
+                bin_boxes[b]    = BBox3d();
+                bin_counts[b]   = 0;
+            }
+            for(uint k=begin; k<end; k++) {
+                const GeomBlob<GeomIdx> &blob = geoms[tmpids[k]];
+                uint b = binIndex(blob.point[d], lo, scale, nBins);
+                bin_boxes[b] = convex(bin_boxes[b], blob.bbox);
+                bin_counts[b]++;
+            }
+            
+            // sweep from the right, then from the left
+            BBox3d  acc;
+            uint    count = 0;
+            for(uint b=nBins-1; b>0; b--) {
+                acc = convex(acc, bin_boxes[b]);
+                count += bin_counts[b];
+                right_area[b]   = (count > 0)? surfaceArea(acc) : 0.0;
+                right_count[b]  = count;
+            }
+            acc     = BBox3d();
+            count   = 0;
+            for(uint b=1; b<nBins; b++) {
+                acc = convex(acc, bin_boxes[b-1]);
+                count += bin_counts[b-1];
+                if(count == 0 || right_count[b] == 0)   continue;
+                double cost = surfaceArea(acc) * count +
+                              right_area[b] * right_count[b];
+                if(cost < best_cost) {
+                    best_cost   = cost;
+                    best_dim    = d;
+                    best_bin    = b;
+                }
+            }
+        }
+        if(best_bin == 0)
+            return begin;
+        
+        // partition about the chosen plane
+        double lo       = centers.minp[best_dim];
+        double scale    = nBins / (centers.maxp[best_dim] - lo);
+        uint front = begin;
+        for(uint k=begin; k<end; k++) {
+            double x = geoms[tmpids[k]].point[best_dim];
+            if(binIndex(x, lo, scale, nBins) < best_bin) {
+                std::swap(tmpids[front], tmpids[k]);
+                front++;
+            }
+        }
+        *dim = best_dim;
+        return front;
+    }
+    static inline uint binIndex(double x, double lo, double scale, uint nBins)
     {
+        return std::min(nBins-1, uint((x - lo) * scale));
+    }
+    
+    // precondition: begin <= select < end
+    void quickSelect(
+        const std::vector< GeomBlob<GeomIdx> > &geoms,
+        std::vector<uint> &tmpids,
+        uint select, uint begin, uint end, uint dim
+    ) {
         // NOTE: values equal to the pivot
         //       may appear on either side of the split
         if(end-1 == select)     return;
         
         // p(ivot)i(ndex) and p(ivot)v(alue)
-        uint pi = randMod(end-begin) + begin;
-        double pv = blobs[tmpids[pi]].point[dim];
+        uint pi = rand_source.randMod(end-begin) + begin;
+        double pv = geoms[tmpids[pi]].point[dim];
         
         int front = begin;
         int back  = end-1;
         while(front < back) {
-            if(blobs[tmpids[front]].point[dim] < pv) {
+            if(geoms[tmpids[front]].point[dim] < pv) {
                 front++;
             }
-            else if(blobs[tmpids[back]].point[dim] > pv) {
+            else if(geoms[tmpids[back]].point[dim] > pv) {
                 back--;
             }
             else {
@@ -154,43 +465,21 @@ private:
                 back--;
             }
         }
-        if(front == back && blobs[tmpids[front]].point[dim] <= pv) {
+        if(front == back && geoms[tmpids[front]].point[dim] <= pv) {
             front++;
         }
         
         if(select < uint(front)) {
-            quickSelect(select, begin, front, dim);
+            quickSelect(geoms, tmpids, select, begin, front, dim);
         } else {
-            quickSelect(select, front, end, dim);
+            quickSelect(geoms, tmpids, select, front, end, dim);
         }
     }
 private:
-    AABVHNode<GeomIdx>                  *root;
-    
-    IterPool< AABVHNode<GeomIdx> >      node_pool;
-    std::vector< GeomBlob<GeomIdx> >    blobs;
-    std::vector<uint>                   tmpids; // used during construction
+    AABVHOptions            options;
+    std::vector<AABVHNode>  nodes;      // nodes[0] is the root
+    std::vector<BBox3d>     prim_boxes; // primitives, in leaf order
+    std::vector<GeomIdx>    prim_ids;
+    RandomSource            rand_source; // picks pivots
 };
 
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
@@ -0,0 +1,236 @@
+// +-------------------------------------------------------------------------
+// | bvhbench.cpp
+// | 
+// | Author: Gilbert Bernstein
+// +-------------------------------------------------------------------------
+// | COPYRIGHT:
+// |    Copyright Gilbert Bernstein 2013
+// |    See the included COPYRIGHT file for further details.
+// |    
+// |    This file is part of the Cork library.
+// |
+// |    Cork is free software: you can redistribute it and/or modify
+// |    it under the terms of the GNU Lesser General Public License as
+// |    published by the Free Software Foundation, either version 3 of
+// |    the License, or (at your option) any later version.
+// |
+// |    Cork is distributed in the hope that it will be useful,
+// |    but WITHOUT ANY WARRANTY; without even the implied warranty of
+// |    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// |    GNU Lesser General Public License for more details.
+// |
+// |    You should have received a copy 
+// |    of the GNU Lesser General Public License
+// |    along with Cork.  If not, see <http://www.gnu.org/licenses/>.
+// +-------------------------------------------------------------------------
+// This file contains a small benchmark for the AABVH queries used
+// during intersection and inside/outside tests.  Both input meshes are
+// tiled into an n x n x n grid of copies to produce larger problems.
+
+#include "files.h"
+#include "prelude.h"
+#include "aabvh.h"
+
+#include <iostream>
+using std::cout;
+using std::cerr;
+using std::endl;
+#include <sstream>
+using std::stringstream;
+using std::string;
+#include <vector>
+
+typedef Files::FileMesh FileMesh;
+
+// append n*n*n copies of the mesh, offset by multiples of spacing
+void tileMesh(const FileMesh &in, uint n, Vec3d spacing, FileMesh *out)
+{
+    for(uint i=0; i<n; i++)
+    for(uint j=0; j<n; j++)
+    for(uint k=0; k<n; k++) {
+        Vec3d offset(i*spacing.x, j*spacing.y, k*spacing.z);
+        int vbase = out->vertices.size();
+        for(auto v : in.vertices) {
+            v.pos += offset;
+            out->vertices.push_back(v);
+        }
+        for(auto t : in.triangles) {
+            t.a += vbase;
+            t.b += vbase;
+            t.c += vbase;
+            out->triangles.push_back(t);
+        }
+    }
+}
+
+BBox3d meshBox(const FileMesh &mesh)
+{
+    BBox3d bbox;
+    for(auto &v : mesh.vertices)
+        bbox = convex(bbox, BBox3d(v.pos, v.pos));
+    return bbox;
+}
+
+BBox3d triBox(const FileMesh &mesh, uint tid)
+{
+    Vec3d p0 = mesh.vertices[mesh.triangles[tid].a].pos;
+    Vec3d p1 = mesh.vertices[mesh.triangles[tid].b].pos;
+    Vec3d p2 = mesh.vertices[mesh.triangles[tid].c].pos;
+    return BBox3d(min(p0, min(p1, p2)), max(p0, max(p1, p2)));
+}
+
+// one blob per edge, taking each edge from the triangle
+// that lists its endpoints in increasing order
+void edgeBlobs(const FileMesh &mesh, std::vector< GeomBlob<uint> > *blobs)
+{
+    for(auto &t : mesh.triangles) {
+        int v[3] = { t.a, t.b, t.c };
+        for(uint k=0; k<3; k++) {
+            int v0 = v[k];
+            int v1 = v[(k+1)%3];
+            if(v0 > v1)     continue;
+            Vec3d p0 = mesh.vertices[v0].pos;
+            Vec3d p1 = mesh.vertices[v1].pos;
+            GeomBlob<uint> blob;
+            blob.bbox   = BBox3d(min(p0, p1), max(p0, p1));
+            blob.point  = (p0 + p1) / 2.0;
+            blob.id     = blobs->size();
+            blobs->push_back(blob);
+        }
+    }
+}
+
+void triBlobs(const FileMesh &mesh, std::vector< GeomBlob<uint> > *blobs)
+{
+    for(uint tid=0; tid<mesh.triangles.size(); tid++) {
+        GeomBlob<uint> blob;
+        blob.bbox   = triBox(mesh, tid);
+        blob.point  = (blob.bbox.minp + blob.bbox.maxp) / 2.0;
+        blob.id     = tid;
+        blobs->push_back(blob);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc < 3 || argc > 7) {
+        cout << "usage: bvhbench in0 in1 [tiles] [repeats] "
+                "[median|sah] [leafsize]" << endl;
+        cout << "    tiles the inputs into a tiles^3 grid (default 4)" << endl;
+        cout << "    and runs each query pass repeats times (default 3)"
+             << endl;
+        cout << "    using median split (default) or SAH hierarchies"
+             << endl;
+        return 1;
+    }
+    uint tiles   = 4;
+    uint repeats = 3;
+    AABVHOptions bvh_opts;
+    if(argc > 3)    stringstream(argv[3]) >> tiles;
+    if(argc > 4)    stringstream(argv[4]) >> repeats;
+    if(argc > 5) {
+        string strategy = argv[5];
+        if(strategy == "sah")
+            bvh_opts.strategy = AABVHOptions::BINNED_SAH;
+        else if(strategy != "median") {
+            cerr << "unknown build strategy " << strategy << endl;
+            return 1;
+        }
+    }
+    if(argc > 6)    stringstream(argv[6]) >> bvh_opts.leafSize;
+    
+    FileMesh in0, in1;
+    if(Files::readTriMesh(argv[1], &in0) > 0) {
+        cerr << "Unable to load in " << argv[1] << endl;
+        return 1;
+    }
+    if(Files::readTriMesh(argv[2], &in1) > 0) {
+        cerr << "Unable to load in " << argv[2] << endl;
+        return 1;
+    }
+    
+    // tile both meshes with the same spacing, so copies of in0 and in1
+    // overlap each other the same way the inputs do
+    Vec3d spacing = dim(convex(meshBox(in0), meshBox(in1)));
+    FileMesh mesh0, mesh1;
+    tileMesh(in0, tiles, spacing, &mesh0);
+    tileMesh(in1, tiles, spacing, &mesh1);
+    cout << "triangles: " << mesh0.triangles.size() << " + "
+         << mesh1.triangles.size() << endl;
+    
+    // build
+    std::vector< GeomBlob<uint> > edge_geoms, tri_geoms;
+    edgeBlobs(mesh1, &edge_geoms);
+    triBlobs(mesh1, &tri_geoms);
+    Timer timer;
+    AABVH<uint> edgeBVH(edge_geoms, bvh_opts);
+    AABVH<uint> triBVH(tri_geoms, bvh_opts);
+    double build_ms = timer.stop();
+    cout << "build:     " << build_ms << " ms for "
+         << edgeBVH.numNodes() + triBVH.numNodes() << " nodes" << endl;
+    
+    // box queries: each triangle of mesh0 against the edges of mesh1,
+    // as when searching for edge-triangle intersections
+    std::vector<BBox3d> query_boxes(mesh0.triangles.size());
+    for(uint tid=0; tid<mesh0.triangles.size(); tid++)
+        query_boxes[tid] = triBox(mesh0, tid);
+    
+    size_t box_hits = 0;
+    timer.start();
+    for(uint r=0; r<repeats; r++) {
+        for(const BBox3d &bbox : query_boxes) {
+            edgeBVH.for_each_in_box(bbox, [&](uint) {
+                box_hits++;
+            });
+        }
+    }
+    double box_ms = timer.stop();
+    double box_queries = double(repeats) * query_boxes.size();
+    cout << "box:       " << box_queries / box_ms * 1000.0 << " queries/s  ("
+         << box_hits / repeats << " hits per pass)" << endl;
+    
+    // simultaneous traversal of a triangle BVH over mesh0
+    // and the edge BVH over mesh1, producing the same pairs
+    std::vector< GeomBlob<uint> > query_geoms;
+    triBlobs(mesh0, &query_geoms);
+    AABVH<uint> queryBVH(query_geoms, bvh_opts);
+    size_t pair_hits = 0;
+    timer.start();
+    for(uint r=0; r<repeats; r++) {
+        queryBVH.for_each_overlapping_pair(edgeBVH, [&](uint, uint) {
+            pair_hits++;
+        });
+    }
+    double pair_ms = timer.stop();
+    cout << "pairs:     " << box_queries / pair_ms * 1000.0
+         << " triangles/s  (" << pair_hits / repeats << " hits per pass)"
+         << endl;
+    
+    // ray queries: from each triangle of mesh0 against the triangles
+    // of mesh1, as when testing whether a component is inside
+    RandomSource rand_source;
+    std::vector<Ray3d> rays(mesh0.triangles.size());
+    for(uint tid=0; tid<mesh0.triangles.size(); tid++) {
+        BBox3d bbox = query_boxes[tid];
+        rays[tid].p = (bbox.minp + bbox.maxp) / 2.0;
+        rays[tid].r = Vec3d(rand_source.drand(0.5,1.5),
+                            rand_source.drand(0.5,1.5),
+                            rand_source.drand(0.5,1.5));
+    }
+    
+    size_t ray_hits = 0;
+    timer.start();
+    for(uint r=0; r<repeats; r++) {
+        for(const Ray3d &ray : rays) {
+            triBVH.for_each_in_ray(ray, [&](uint) {
+                ray_hits++;
+            });
+        }
+    }
+    double ray_ms = timer.stop();
+    double ray_queries = double(repeats) * rays.size();
+    cout << "ray:       " << ray_queries / ray_ms * 1000.0 << " queries/s  ("
+         << ray_hits / repeats << " hits per pass)" << endl;
+    
+    return 0;
+}
@@ -27,6 +27,11 @@
 
 #include "mesh.h"
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <functional>
+
 
 void freeCorkTriMesh(CorkTriMesh *mesh)
 {
@@ -36,6 +41,15 @@ void freeCorkTriMesh(CorkTriMesh *mesh)
     mesh->n_vertices = 0;
 }
 
+void freeCorkPolylines(CorkPolylines *curves)
+{
+    delete[] curves->curve_starts;
+    delete[] curves->closed;
+    delete[] curves->points;
+    curves->n_curves = 0;
+    curves->n_points = 0;
+}
+
 
 struct CorkTriangle;
 
@@ -101,6 +115,7 @@ struct CorkTriangle :
     void subdivide(SubdivideTriInput<CorkVertex,CorkTriangle> input)
     {
         bool_alg_data = input.pt->bool_alg_data;
+        bool_operand  = input.pt->bool_operand;
     }
 };
 
@@ -177,11 +192,17 @@ void corkMesh2CorkTriMesh(
 }
 
 
-bool isSolid(CorkTriMesh cmesh)
+// Cork's internal form of an input mesh, see prepareCorkMesh()
+struct CorkPreparedMesh
+{
+    CorkMesh    mesh;
+    std::mutex  solid_mutex;    // guards the two flags below
+    bool        solid_known;
+    bool        solid;
+};
+
+static bool isSolid(CorkMesh &mesh)
 {
-    CorkMesh mesh;
-    corkTriMesh2CorkMesh(cmesh, &mesh);
-    
     bool solid = true;
     
     if(mesh.isSelfIntersecting()) {
@@ -197,67 +218,582 @@ bool isSolid(CorkTriMesh cmesh)
     return solid;
 }
 
-void computeUnion(
-    CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out
+bool isSolid(CorkTriMesh cmesh)
+{
+    CorkMesh mesh;
+    corkTriMesh2CorkMesh(cmesh, &mesh);
+    
+    return isSolid(mesh);
+}
+
+CorkPreparedMesh* prepareCorkMesh(CorkTriMesh mesh)
+{
+    CorkPreparedMesh *prepared = new CorkPreparedMesh();
+    corkTriMesh2CorkMesh(mesh, &prepared->mesh);
+    prepared->mesh.prepareBoolOperand();
+    prepared->solid_known = false;
+    prepared->solid = false;
+    return prepared;
+}
+
+void freeCorkPreparedMesh(CorkPreparedMesh *mesh)
+{
+    delete mesh;
+}
+
+bool isSolid(CorkPreparedMesh *prepared)
+{
+    std::lock_guard<std::mutex> lock(prepared->solid_mutex);
+    if(!prepared->solid_known) {
+        prepared->solid = isSolid(prepared->mesh);
+        prepared->solid_known = true;
+    }
+    return prepared->solid;
+}
+
+void applyCorkOptions(
+    const CorkOptions &options,
+    CorkMesh *mesh
 ) {
-    CorkMesh cmIn0, cmIn1;
-    corkTriMesh2CorkMesh(in0, &cmIn0);
-    corkTriMesh2CorkMesh(in1, &cmIn1);
+    mesh->isct_options.numThreads = options.n_threads;
+    mesh->isct_options.crossOperandOnly = options.cross_operand_only;
+    mesh->isct_options.overlapOnly = options.overlap_only;
+    mesh->isct_options.sahBVH = options.sah_bvh;
+    mesh->isct_options.bvhLeafSize = options.bvh_leaf_size;
+}
+
+void reportCorkStats(
+    const CorkOptions &options,
+    const CorkMesh &mesh,
+    Timer &timer
+) {
+    if(!options.stats)
+        return;
+    const IsctStats &in = mesh.isct_stats;
+    CorkStats       &out = *options.stats;
+    out.candidate_pairs = in.candidatePairs;
+    out.predicate_calls = in.predicateCalls;
+    out.filter_failures = in.ddoubleCalls;
+    out.exact_fallbacks = in.exactCalls;
+    out.degeneracies    = in.degeneracies;
+    out.perturb_retries = in.perturbRetries;
+    out.glue_points     = in.gluePoints;
+    out.tris_subdivided = in.trisSubdivided;
+    out.find_ms         = in.findMs;
+    out.subdivide_ms    = in.subdivideMs;
+    out.classify_ms     = in.classifyMs;
+    out.delete_flip_ms  = in.deleteFlipMs;
+    out.arena_peak_bytes = in.arenaPeakBytes;
+    out.total_ms        = timer.stop();
+}
+
+// lhs = lhs OP rhs; false if the intersections couldn't be resolved
+typedef std::function<bool(CorkMesh &lhs, const CorkMesh &rhs)> CorkBinaryOp;
+
+static bool resolveOp(CorkMesh &lhs, const CorkMesh &rhs)
+{
+    lhs.disjointUnion(rhs);
+    return lhs.resolveIntersections();
+}
+
+// run op on meshes already converted by the caller, who started timer.
+// out is only written if op succeeds; the stats are reported either way
+static bool runBinaryOp(
+    CorkBinaryOp op,
+    CorkMesh &in0, const CorkMesh &in1, CorkTriMesh *out,
+    const CorkOptions &options, Timer &timer
+) {
+    applyCorkOptions(options, &in0);
     
-    cmIn0.boolUnion(cmIn1);
+    bool success = op(in0, in1);
     
-    corkMesh2CorkTriMesh(&cmIn0, out);
+    if(success)
+        corkMesh2CorkTriMesh(&in0, out);
+    reportCorkStats(options, in0, timer);
+    return success;
 }
 
-void computeDifference(
-    CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out
+static bool runBinaryOp(
+    CorkBinaryOp op,
+    CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out,
+    const CorkOptions &options
 ) {
+    Timer timer;
     CorkMesh cmIn0, cmIn1;
     corkTriMesh2CorkMesh(in0, &cmIn0);
     corkTriMesh2CorkMesh(in1, &cmIn1);
+    return runBinaryOp(op, cmIn0, cmIn1, out, options, timer);
+}
+
+// the result is built in a copy of in0; in1 is used as is
+static bool runBinaryOp(
+    CorkBinaryOp op,
+    const CorkPreparedMesh *in0, const CorkPreparedMesh *in1,
+    CorkTriMesh *out,
+    const CorkOptions &options
+) {
+    Timer timer;
+    CorkMesh cmIn0;
+    cmIn0.disjointUnion(in0->mesh);
+    return runBinaryOp(op, cmIn0, in1->mesh, out, options, timer);
+}
+
+bool computeUnion(
+    CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out
+) {
+    return computeUnion(in0, in1, out, CorkOptions());
+}
+
+bool computeUnion(
+    CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out,
+    const CorkOptions &options
+) {
+    return runBinaryOp(&CorkMesh::boolUnion, in0, in1, out, options);
+}
+
+bool computeUnion(
+    const CorkPreparedMesh *in0, const CorkPreparedMesh *in1, CorkTriMesh *out
+) {
+    return computeUnion(in0, in1, out, CorkOptions());
+}
+
+bool computeUnion(
+    const CorkPreparedMesh *in0, const CorkPreparedMesh *in1, CorkTriMesh *out,
+    const CorkOptions &options
+) {
+    return runBinaryOp(&CorkMesh::boolUnion, in0, in1, out, options);
+}
+
+bool computeDifference(
+    CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out
+) {
+    return computeDifference(in0, in1, out, CorkOptions());
+}
+
+bool computeDifference(
+    CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out,
+    const CorkOptions &options
+) {
+    return runBinaryOp(&CorkMesh::boolDiff, in0, in1, out, options);
+}
+
+bool computeDifference(
+    const CorkPreparedMesh *in0, const CorkPreparedMesh *in1, CorkTriMesh *out
+) {
+    return computeDifference(in0, in1, out, CorkOptions());
+}
+
+bool computeDifference(
+    const CorkPreparedMesh *in0, const CorkPreparedMesh *in1, CorkTriMesh *out,
+    const CorkOptions &options
+) {
+    return runBinaryOp(&CorkMesh::boolDiff, in0, in1, out, options);
+}
+
+bool computeIntersection(
+    CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out
+) {
+    return computeIntersection(in0, in1, out, CorkOptions());
+}
+
+bool computeIntersection(
+    CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out,
+    const CorkOptions &options
+) {
+    return runBinaryOp(&CorkMesh::boolIsct, in0, in1, out, options);
+}
+
+bool computeIntersection(
+    const CorkPreparedMesh *in0, const CorkPreparedMesh *in1, CorkTriMesh *out
+) {
+    return computeIntersection(in0, in1, out, CorkOptions());
+}
+
+bool computeIntersection(
+    const CorkPreparedMesh *in0, const CorkPreparedMesh *in1, CorkTriMesh *out,
+    const CorkOptions &options
+) {
+    return runBinaryOp(&CorkMesh::boolIsct, in0, in1, out, options);
+}
+
+bool computeSymmetricDifference(
+    CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out
+) {
+    return computeSymmetricDifference(in0, in1, out, CorkOptions());
+}
+
+bool computeSymmetricDifference(
+    CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out,
+    const CorkOptions &options
+) {
+    return runBinaryOp(&CorkMesh::boolXor, in0, in1, out, options);
+}
+
+bool computeSymmetricDifference(
+    const CorkPreparedMesh *in0, const CorkPreparedMesh *in1, CorkTriMesh *out
+) {
+    return computeSymmetricDifference(in0, in1, out, CorkOptions());
+}
+
+bool computeSymmetricDifference(
+    const CorkPreparedMesh *in0, const CorkPreparedMesh *in1, CorkTriMesh *out,
+    const CorkOptions &options
+) {
+    return runBinaryOp(&CorkMesh::boolXor, in0, in1, out, options);
+}
+
+bool resolveIntersections(
+    CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out
+) {
+    return resolveIntersections(in0, in1, out, CorkOptions());
+}
+
+bool resolveIntersections(
+    CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out,
+    const CorkOptions &options
+) {
+    return runBinaryOp(resolveOp, in0, in1, out, options);
+}
+
+bool resolveIntersections(
+    const CorkPreparedMesh *in0, const CorkPreparedMesh *in1, CorkTriMesh *out
+) {
+    return resolveIntersections(in0, in1, out, CorkOptions());
+}
+
+bool resolveIntersections(
+    const CorkPreparedMesh *in0, const CorkPreparedMesh *in1, CorkTriMesh *out,
+    const CorkOptions &options
+) {
+    return runBinaryOp(resolveOp, in0, in1, out, options);
+}
+
+// lhs = OP(lhs, rest[0], rest[1] ...), as CorkBinaryOp
+typedef std::function<bool(CorkMesh &lhs,
+                           const std::vector<const CorkMesh*> &rest)>
+        CorkNaryOp;
+
+static bool runNaryOp(
+    CorkNaryOp op,
+    CorkMesh &in0, const std::vector<const CorkMesh*> &rest,
+    CorkTriMesh *out,
+    const CorkOptions &options, Timer &timer
+) {
+    applyCorkOptions(options, &in0);
     
-    cmIn0.boolDiff(cmIn1);
+    bool success = op(in0, rest);
     
-    corkMesh2CorkTriMesh(&cmIn0, out);
+    if(success)
+        corkMesh2CorkTriMesh(&in0, out);
+    reportCorkStats(options, in0, timer);
+    return success;
 }
 
-void computeIntersection(
-    CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out
+bool computeNaryUnion(
+    const CorkTriMesh *in, uint n, CorkTriMesh *out
+) {
+    return computeNaryUnion(in, n, out, CorkOptions());
+}
+
+bool computeNaryUnion(
+    const CorkTriMesh *in, uint n, CorkTriMesh *out,
+    const CorkOptions &options
+) {
+    Timer timer;
+    if(n == 0) {
+        CorkMesh empty;
+        corkMesh2CorkTriMesh(&empty, out);
+        reportCorkStats(options, empty, timer);
+        return true;
+    }
+    std::vector<CorkMesh> cmIn(n);
+    for(uint i=0; i<n; i++)
+        corkTriMesh2CorkMesh(in[i], &cmIn[i]);
+    std::vector<const CorkMesh*> rest;
+    for(uint i=1; i<n; i++)
+        rest.push_back(&cmIn[i]);
+    return runNaryOp(&CorkMesh::boolNaryUnion, cmIn[0], rest, out, options,
+                     timer);
+}
+
+bool computeNaryUnion(
+    const CorkPreparedMesh *const *in, uint n, CorkTriMesh *out
+) {
+    return computeNaryUnion(in, n, out, CorkOptions());
+}
+
+bool computeNaryUnion(
+    const CorkPreparedMesh *const *in, uint n, CorkTriMesh *out,
+    const CorkOptions &options
+) {
+    Timer timer;
+    if(n == 0) {
+        CorkMesh empty;
+        corkMesh2CorkTriMesh(&empty, out);
+        reportCorkStats(options, empty, timer);
+        return true;
+    }
+    CorkMesh cmIn0;
+    cmIn0.disjointUnion(in[0]->mesh);
+    std::vector<const CorkMesh*> rest;
+    for(uint i=1; i<n; i++)
+        rest.push_back(&in[i]->mesh);
+    return runNaryOp(&CorkMesh::boolNaryUnion, cmIn0, rest, out, options,
+                     timer);
+}
+
+// every node must refer to an input that exists, or to two nodes
+// before it, so that the last node is the root of the expression
+static bool isValidCsg(
+    uint n_in, const CorkCsgNode *nodes, uint n_nodes
+) {
+    if(n_nodes == 0)
+        return false;
+    for(uint i=0; i<n_nodes; i++) {
+        switch(nodes[i].op) {
+        case CorkCsgNode::OPERAND:
+            if(nodes[i].operand >= n_in)
+                return false;
+            break;
+        case CorkCsgNode::UNION:
+        case CorkCsgNode::DIFFERENCE:
+        case CorkCsgNode::INTERSECTION:
+        case CorkCsgNode::SYMMETRIC_DIFFERENCE:
+            if(nodes[i].left >= i || nodes[i].right >= i)
+                return false;
+            break;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+// The inputs the expression uses, in increasing order.  Input
+// used[k] becomes operand k of the combined mesh
+static std::vector<uint> csgOperands(
+    uint n_in, const CorkCsgNode *nodes, uint n_nodes
 ) {
+    std::vector<bool> is_used(n_in, false);
+    for(uint i=0; i<n_nodes; i++)
+        if(nodes[i].op == CorkCsgNode::OPERAND)
+            is_used[nodes[i].operand] = true;
+    std::vector<uint> used;
+    for(uint k=0; k<n_in; k++)
+        if(is_used[k])
+            used.push_back(k);
+    return used;
+}
+
+// lhs = the expression, with lhs and rest as the inputs in used
+static bool csgOp(
+    const CorkCsgNode *nodes, uint n_nodes, const std::vector<uint> &used,
+    CorkMesh &lhs, const std::vector<const CorkMesh*> &rest
+) {
+    std::vector<uint> operand_of(used.back() + 1, 0);
+    for(uint k=0; k<used.size(); k++)
+        operand_of[used[k]] = k;
+    
+    // evaluate the nodes in order, children before their parents
+    std::vector<bool> values(n_nodes);
+    return lhs.boolNary(rest, [&](const std::vector<bool> &inside) -> bool {
+        for(uint i=0; i<n_nodes; i++) {
+            const CorkCsgNode &node = nodes[i];
+            switch(node.op) {
+            case CorkCsgNode::OPERAND:
+                values[i] = inside[operand_of[node.operand]];
+                break;
+            case CorkCsgNode::UNION:
+                values[i] = values[node.left] || values[node.right];
+                break;
+            case CorkCsgNode::DIFFERENCE:
+                values[i] = values[node.left] && !values[node.right];
+                break;
+            case CorkCsgNode::INTERSECTION:
+                values[i] = values[node.left] && values[node.right];
+                break;
+            case CorkCsgNode::SYMMETRIC_DIFFERENCE:
+                values[i] = values[node.left] != values[node.right];
+                break;
+            }
+        }
+        return values[n_nodes-1];
+    });
+}
+
+bool computeCsg(
+    const CorkTriMesh *in, uint n_in,
+    const CorkCsgNode *nodes, uint n_nodes, CorkTriMesh *out
+) {
+    return computeCsg(in, n_in, nodes, n_nodes, out, CorkOptions());
+}
+
+bool computeCsg(
+    const CorkTriMesh *in, uint n_in,
+    const CorkCsgNode *nodes, uint n_nodes, CorkTriMesh *out,
+    const CorkOptions &options
+) {
+    if(!isValidCsg(n_in, nodes, n_nodes))
+        return false;
+    Timer timer;
+    std::vector<uint> used = csgOperands(n_in, nodes, n_nodes);
+    std::vector<CorkMesh> cmIn(used.size());
+    for(uint k=0; k<used.size(); k++)
+        corkTriMesh2CorkMesh(in[used[k]], &cmIn[k]);
+    std::vector<const CorkMesh*> rest;
+    for(uint k=1; k<used.size(); k++)
+        rest.push_back(&cmIn[k]);
+    return runNaryOp(
+    [&](CorkMesh &lhs, const std::vector<const CorkMesh*> &others) {
+        return csgOp(nodes, n_nodes, used, lhs, others);
+    }, cmIn[0], rest, out, options, timer);
+}
+
+bool computeCsg(
+    const CorkPreparedMesh *const *in, uint n_in,
+    const CorkCsgNode *nodes, uint n_nodes, CorkTriMesh *out
+) {
+    return computeCsg(in, n_in, nodes, n_nodes, out, CorkOptions());
+}
+
+bool computeCsg(
+    const CorkPreparedMesh *const *in, uint n_in,
+    const CorkCsgNode *nodes, uint n_nodes, CorkTriMesh *out,
+    const CorkOptions &options
+) {
+    if(!isValidCsg(n_in, nodes, n_nodes))
+        return false;
+    Timer timer;
+    std::vector<uint> used = csgOperands(n_in, nodes, n_nodes);
+    CorkMesh cmIn0;
+    cmIn0.disjointUnion(in[used[0]]->mesh);
+    std::vector<const CorkMesh*> rest;
+    for(uint k=1; k<used.size(); k++)
+        rest.push_back(&in[used[k]]->mesh);
+    return runNaryOp(
+    [&](CorkMesh &lhs, const std::vector<const CorkMesh*> &others) {
+        return csgOp(nodes, n_nodes, used, lhs, others);
+    }, cmIn0, rest, out, options, timer);
+}
+
+bool intersects(CorkTriMesh in0, CorkTriMesh in1)
+{
     CorkMesh cmIn0, cmIn1;
     corkTriMesh2CorkMesh(in0, &cmIn0);
     corkTriMesh2CorkMesh(in1, &cmIn1);
-    
-    cmIn0.boolIsct(cmIn1);
-    
-    corkMesh2CorkTriMesh(&cmIn0, out);
+    return cmIn0.boolIntersects(cmIn1);
 }
 
-void computeSymmetricDifference(
-    CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out
-) {
+bool intersects(const CorkPreparedMesh *in0, const CorkPreparedMesh *in1)
+{
+    return in0->mesh.boolIntersects(in1->mesh);
+}
+
+static CorkNesting corkNesting(CorkMesh::Nesting nesting)
+{
+    switch(nesting) {
+    case CorkMesh::APART:       return CORK_APART;
+    case CorkMesh::LHS_IN_RHS:  return CORK_IN0_IN_IN1;
+    case CorkMesh::RHS_IN_LHS:  return CORK_IN1_IN_IN0;
+    case CorkMesh::PARTLY_INSIDE:   return CORK_PARTLY_INSIDE;
+    case CorkMesh::SURFACES_MEET:
+    default:                    return CORK_INTERSECTING;
+    }
+}
+
+CorkNesting classify(CorkTriMesh in0, CorkTriMesh in1)
+{
     CorkMesh cmIn0, cmIn1;
     corkTriMesh2CorkMesh(in0, &cmIn0);
     corkTriMesh2CorkMesh(in1, &cmIn1);
+    return corkNesting(cmIn0.boolNesting(cmIn1));
+}
+
+CorkNesting classify(const CorkPreparedMesh *in0, const CorkPreparedMesh *in1)
+{
+    return corkNesting(in0->mesh.boolNesting(in1->mesh));
+}
+
+void isctCurves2CorkPolylines(
+    const std::vector<CorkMesh::IsctCurve> &curves,
+    CorkPolylines *out
+) {
+    out->n_curves = curves.size();
+    out->n_points = 0;
+    for(const CorkMesh::IsctCurve &curve : curves)
+        out->n_points += curve.points.size();
     
-    cmIn0.boolXor(cmIn1);
+    out->curve_starts = new uint[out->n_curves + 1];
+    out->closed       = new bool[out->n_curves];
+    out->points       = new float[(out->n_points) * 3];
     
-    corkMesh2CorkTriMesh(&cmIn0, out);
+    uint write = 0;
+    for(uint k=0; k<out->n_curves; k++) {
+        (out->curve_starts)[k] = write;
+        (out->closed)[k] = curves[k].closed;
+        for(const Vec3d &p : curves[k].points) {
+            (out->points)[3*write+0] = static_cast<float>(p.x);
+            (out->points)[3*write+1] = static_cast<float>(p.y);
+            (out->points)[3*write+2] = static_cast<float>(p.z);
+            write++;
+        }
+    }
+    (out->curve_starts)[out->n_curves] = write;
 }
 
-void resolveIntersections(
-    CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out
+// run on meshes already converted by the caller, who started timer
+static bool runIsctCurves(
+    CorkMesh &in0, const CorkMesh &in1, CorkPolylines *out,
+    const CorkOptions &options, Timer &timer
 ) {
+    applyCorkOptions(options, &in0);
+    
+    std::vector<CorkMesh::IsctCurve> curves;
+    bool success = in0.isctCurves(in1, &curves);
+    
+    if(success)
+        isctCurves2CorkPolylines(curves, out);
+    reportCorkStats(options, in0, timer);
+    return success;
+}
+
+bool computeIntersectionCurves(
+    CorkTriMesh in0, CorkTriMesh in1, CorkPolylines *out
+) {
+    return computeIntersectionCurves(in0, in1, out, CorkOptions());
+}
+
+bool computeIntersectionCurves(
+    CorkTriMesh in0, CorkTriMesh in1, CorkPolylines *out,
+    const CorkOptions &options
+) {
+    Timer timer;
     CorkMesh cmIn0, cmIn1;
     corkTriMesh2CorkMesh(in0, &cmIn0);
     corkTriMesh2CorkMesh(in1, &cmIn1);
-    
-    cmIn0.disjointUnion(cmIn1);
-    cmIn0.resolveIntersections();
-    
-    corkMesh2CorkTriMesh(&cmIn0, out);
+    return runIsctCurves(cmIn0, cmIn1, out, options, timer);
 }
 
+bool computeIntersectionCurves(
+    const CorkPreparedMesh *in0, const CorkPreparedMesh *in1,
+    CorkPolylines *out
+) {
+    return computeIntersectionCurves(in0, in1, out, CorkOptions());
+}
+
+// in0 is copied to carry the options and statistics; in1 is used as is
+bool computeIntersectionCurves(
+    const CorkPreparedMesh *in0, const CorkPreparedMesh *in1,
+    CorkPolylines *out,
+    const CorkOptions &options
+) {
+    Timer timer;
+    CorkMesh cmIn0;
+    cmIn0.disjointUnion(in0->mesh);
+    return runIsctCurves(cmIn0, in1->mesh, out, options, timer);
+}
+
+
 void translateZ(CorkTriMesh& in0, float deltaZ)
 {
 	for (uint i = 0; i < in0.n_vertices; i++) {
@@ -289,15 +825,63 @@ extern bool loadMesh(std::string filename, CorkTriMesh& out);
 extern void saveMesh(std::string filename, CorkTriMesh in);
 
 namespace CorkCommander {
-#include <map>
-	static std::map<std::string, CorkTriMesh*> meshDict;
-	
+
+	// Meshes in the dictionary are never modified once stored.
+	// Operations look up their inputs while holding the lock, compute
+	// without it, and then store a new mesh.  A mesh that is deleted or
+	// replaced while another thread still uses it stays alive until that
+	// thread is done with it.
+	typedef std::shared_ptr<const CorkTriMesh> MeshPtr;
+
+	static std::mutex meshDictMutex;
+	static std::map<std::string, MeshPtr> meshDict;
+
+	// takes ownership of pMesh and its arrays
+	static MeshPtr makeMeshPtr(CorkTriMesh* pMesh)
+	{
+		return MeshPtr(pMesh, [](const CorkTriMesh* p) {
+			CorkTriMesh* owned = const_cast<CorkTriMesh*>(p);
+			freeCorkTriMesh(owned);
+			delete owned;
+		});
+	}
+
+	static CorkTriMesh* copyCorkTriMesh(const CorkTriMesh& src)
+	{
+		CorkTriMesh* pMesh = new CorkTriMesh();
+		pMesh->n_triangles = src.n_triangles;
+		pMesh->n_vertices = src.n_vertices;
+		pMesh->triangles = new uint[src.n_triangles * 3];
+		pMesh->vertices = new float[src.n_vertices * 3];
+		std::copy(src.triangles, src.triangles + src.n_triangles * 3,
+		          pMesh->triangles);
+		std::copy(src.vertices, src.vertices + src.n_vertices * 3,
+		          pMesh->vertices);
+		return pMesh;
+	}
+
+	static MeshPtr findMesh(const std::string& ID)
+	{
+		std::lock_guard<std::mutex> lock(meshDictMutex);
+		auto it = meshDict.find(ID);
+		if (it == meshDict.end()) {
+			return MeshPtr();
+		}
+		return it->second;
+	}
+
+	static void storeMesh(const std::string& ID, MeshPtr mesh)
+	{
+		std::lock_guard<std::mutex> lock(meshDictMutex);
+		meshDict[ID] = mesh;
+	}
+
 	bool LoadMesh(std::string ID, std::string fileName)
 	{
 		CorkTriMesh* pMesh = new CorkTriMesh();
 		bool success = loadMesh(fileName, *pMesh);
 		if (success) {
-			meshDict[ID] = pMesh;
+			storeMesh(ID, makeMeshPtr(pMesh));
 		}
 		else {
 			delete pMesh;
@@ -307,154 +891,123 @@ namespace CorkCommander {
 
 	bool SaveMesh(std::string ID, std::string fileName)
 	{
-		auto it = meshDict.find(ID);
-		if (it == meshDict.end()) {
+		MeshPtr mesh = findMesh(ID);
+		if (!mesh) {
 			return false;
 		}
-		saveMesh(fileName, *it->second);
+		saveMesh(fileName, *mesh);
 		return true;
 	}
 
 	void ClearAllMeshes()
 	{
-		for (auto it = meshDict.begin(); it != meshDict.end(); it++) {
-			delete(it->second);
-		}
+		std::lock_guard<std::mutex> lock(meshDictMutex);
 		meshDict.clear();
 	}
 
 	bool DeleteMesh(std::string ID)
 	{
-		auto it = meshDict.find(ID);
-		if (it == meshDict.end()) {
-			return false;
-		}
-		delete(it->second);
-		meshDict.erase(it);
-		return true;
+		std::lock_guard<std::mutex> lock(meshDictMutex);
+		return meshDict.erase(ID) > 0;
 	}
 
 	bool CopyMesh(std::string srcID, std::string destID)
 	{
-		auto it = meshDict.find(srcID);
-		if (it == meshDict.end()) {
+		MeshPtr mesh = findMesh(srcID);
+		if (!mesh) {
 			return false;
 		}
-		CorkTriMesh* pMesh = new CorkTriMesh();
-		*pMesh = *it->second;
-		meshDict[destID] = pMesh;
+		storeMesh(destID, makeMeshPtr(copyCorkTriMesh(*mesh)));
 		return true;
 	}
 
 	bool IsSolid(std::string ID)
 	{
-		auto it = meshDict.find(ID);
-		if (it == meshDict.end()) {
+		MeshPtr mesh = findMesh(ID);
+		if (!mesh) {
 			return false;
 		}
-		return isSolid(*it->second);
+		return isSolid(*mesh);
 	}
 
-	bool Union(std::string InID1, std::string InID2, std::string OutID)
+	typedef bool (*BinaryOp)(CorkTriMesh, CorkTriMesh, CorkTriMesh*);
+
+	static bool applyBinaryOp(BinaryOp op,
+	                          std::string InID1, std::string InID2,
+	                          std::string OutID)
 	{
-		auto it1 = meshDict.find(InID1);
-		if (it1 == meshDict.end()) {
+		MeshPtr in1 = findMesh(InID1);
+		if (!in1) {
 			return false;
 		}
-		auto it2 = meshDict.find(InID2);
-		if (it2 == meshDict.end()) {
+		MeshPtr in2 = findMesh(InID2);
+		if (!in2) {
 			return false;
 		}
-		DeleteMesh("OutID");
 
 		CorkTriMesh* pMesh = new CorkTriMesh();
-		computeUnion(*it1->second, *it2->second, pMesh);
-		meshDict[OutID] = pMesh;
+		if (!op(*in1, *in2, pMesh)) {
+			delete pMesh;
+			return false;
+		}
+		storeMesh(OutID, makeMeshPtr(pMesh));
 		return true;
 	}
 
-	bool Difference(std::string InID1, std::string InID2, std::string OutID)
+	bool Union(std::string InID1, std::string InID2, std::string OutID)
 	{
-		auto it1 = meshDict.find(InID1);
-		if (it1 == meshDict.end()) {
-			return false;
-		}
-		auto it2 = meshDict.find(InID2);
-		if (it2 == meshDict.end()) {
-			return false;
-		}
-		DeleteMesh("OutID");
+		return applyBinaryOp(computeUnion, InID1, InID2, OutID);
+	}
 
-		CorkTriMesh* pMesh = new CorkTriMesh();
-		computeDifference(*it1->second, *it2->second, pMesh);
-		meshDict[OutID] = pMesh;
-		return true;
+	bool Difference(std::string InID1, std::string InID2, std::string OutID)
+	{
+		return applyBinaryOp(computeDifference, InID1, InID2, OutID);
 	}
 
 	bool Intersection(std::string InID1, std::string InID2, std::string OutID)
 	{
-		auto it1 = meshDict.find(InID1);
-		if (it1 == meshDict.end()) {
-			return false;
-		}
-		auto it2 = meshDict.find(InID2);
-		if (it2 == meshDict.end()) {
-			return false;
-		}
-		DeleteMesh("OutID");
-
-		CorkTriMesh* pMesh = new CorkTriMesh();
-		computeIntersection(*it1->second, *it2->second, pMesh);
-		meshDict[OutID] = pMesh;
-		return true;
+		return applyBinaryOp(computeIntersection, InID1, InID2, OutID);
 	}
 
 	bool Xor(std::string InID1, std::string InID2, std::string OutID)
 	{
-		auto it1 = meshDict.find(InID1);
-		if (it1 == meshDict.end()) {
-			return false;
-		}
-		auto it2 = meshDict.find(InID2);
-		if (it2 == meshDict.end()) {
+		return applyBinaryOp(computeSymmetricDifference, InID1, InID2, OutID);
+	}
+
+	// stored meshes are immutable, so transform a copy and replace the
+	// original with it
+	static bool transformMesh(std::string ID,
+	                          std::function<void(CorkTriMesh&)> transform)
+	{
+		MeshPtr mesh = findMesh(ID);
+		if (!mesh) {
 			return false;
 		}
-		DeleteMesh("OutID");
-
-		CorkTriMesh* pMesh = new CorkTriMesh();
-		computeSymmetricDifference(*it1->second, *it2->second, pMesh);
-		meshDict[OutID] = pMesh;
+		CorkTriMesh* pMesh = copyCorkTriMesh(*mesh);
+		transform(*pMesh);
+		storeMesh(ID, makeMeshPtr(pMesh));
 		return true;
 	}
 
 	bool TranslateZ(std::string ID, float deltaZ)
 	{
-		auto it = meshDict.find(ID);
-		if (it == meshDict.end()) {
-			return false;
-		}
-		translateZ(*it->second, deltaZ);
-		return true;
+		return transformMesh(ID, [deltaZ](CorkTriMesh& mesh) {
+			translateZ(mesh, deltaZ);
+		});
 	}
 
 	bool Rotate180X(std::string ID)
 	{
-		auto it = meshDict.find(ID);
-		if (it == meshDict.end()) {
-			return false;
-		}
-		rotate180X(*it->second);
-		return true;
+		return transformMesh(ID, [](CorkTriMesh& mesh) {
+			rotate180X(mesh);
+		});
 	}
 	
 	bool Rotate180Y(std::string ID)
 	{
-		auto it = meshDict.find(ID);
-		if (it == meshDict.end()) {
-			return false;
-		}
-		rotate180Y(*it->second);
-		return true;
+		return transformMesh(ID, [](CorkTriMesh& mesh) {
+			rotate180Y(mesh);
+		});
 	}
 
 }
@@ -67,24 +67,239 @@ CORKLIBRARY_API void saveMesh(std::string filename, CorkTriMesh in);
 // This function will test whether or not a mesh is solid
 CORKLIBRARY_API bool isSolid(CorkTriMesh mesh);
 
+// statistics about one of the operations below; see CorkOptions::stats.
+// Times are wall clock milliseconds.
+struct CorkStats
+{
+    uint    candidate_pairs;    // edge-triangle pairs with overlapping boxes
+    uint    predicate_calls;    // intersection tests run on candidates
+    uint    filter_failures;    // tests the floating point filter
+                                // couldn't decide
+    uint    exact_fallbacks;    // tests that needed exact arithmetic
+    uint    degeneracies;       // degenerate configurations encountered
+    uint    perturb_retries;    // times the inputs were perturbed and the
+                                // search for intersections restarted
+    uint    glue_points;        // intersection points created
+    uint    tris_subdivided;    // triangles split by intersections
+    double  find_ms;            // finding intersections
+    double  subdivide_ms;       // splitting the intersected triangles
+    double  classify_ms;        // inside/outside tests (Boolean ops only)
+    double  delete_flip_ms;     // removing triangles (Boolean ops only)
+    double  total_ms;           // the whole operation, incl. conversions
+    size_t  arena_peak_bytes;   // most scratch memory used at once while
+                                // finding and splitting intersections
+    CorkStats() :
+        candidate_pairs(0), predicate_calls(0), filter_failures(0),
+        exact_fallbacks(0), degeneracies(0), perturb_retries(0),
+        glue_points(0), tris_subdivided(0), find_ms(0.0), subdivide_ms(0.0),
+        classify_ms(0.0), delete_flip_ms(0.0), total_ms(0.0),
+        arena_peak_bytes(0) {}
+    // fraction of the intersection tests decided by the fast filter
+    double filterPassRate() const {
+        return (predicate_calls > 0)?
+            1.0 - double(filter_failures) / predicate_calls : 1.0;
+    }
+};
+
+// options controlling how the operations below are computed.
+// Each operation also has an overload without options,
+// which uses the defaults.
+struct CorkOptions
+{
+    uint    n_threads;  // number of threads used to find intersections;
+                        // 0 means one thread per hardware thread
+    bool    cross_operand_only; // Boolean operations only search for
+                        // intersections between in0 and in1, not within
+                        // either one.  Faster, but only correct if both
+                        // inputs are non-self-intersecting (see isSolid())
+    bool    overlap_only;   // Boolean operations only resolve the
+                        // triangles near the overlap of the inputs'
+                        // bounding boxes.  Same requirement as above
+    bool    sah_bvh;    // build bounding volume hierarchies with the
+                        // surface area heuristic; often faster for
+                        // meshes with long, thin triangles
+    uint    bvh_leaf_size;  // max triangles or edges per hierarchy leaf
+    CorkStats *stats;   // if not null, overwritten with statistics
+                        // about each operation run with these options
+    CorkOptions() :
+        n_threads(1), cross_operand_only(false), overlap_only(false),
+        sah_bvh(false), bvh_leaf_size(8), stats(nullptr) {}
+};
+
 // Boolean operations follow
+//  Each returns false, leaving out untouched, in the rare case that
+//  the inputs are so degenerate that perturbing them repeatedly
+//  doesn't resolve their intersections.
 // result = A U B
-CORKLIBRARY_API void computeUnion(CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out);
+CORKLIBRARY_API bool computeUnion(CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out);
+CORKLIBRARY_API bool computeUnion(CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out,
+                                  const CorkOptions &options);
 
 // result = A - B
-CORKLIBRARY_API void computeDifference(CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out);
+CORKLIBRARY_API bool computeDifference(CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out);
+CORKLIBRARY_API bool computeDifference(CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out,
+                                       const CorkOptions &options);
 
 // result = A ^ B
-CORKLIBRARY_API void computeIntersection(CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out);
+CORKLIBRARY_API bool computeIntersection(CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out);
+CORKLIBRARY_API bool computeIntersection(CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out,
+                                         const CorkOptions &options);
 
 // result = A XOR B
-CORKLIBRARY_API void computeSymmetricDifference(CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out);
+CORKLIBRARY_API bool computeSymmetricDifference(CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out);
+CORKLIBRARY_API bool computeSymmetricDifference(CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out,
+                                                const CorkOptions &options);
 
 // Not a Boolean operation, but related:
 //  No portion of either surface is deleted.  However, the
 //  curve of intersection between the two surfaces is made explicit,
 //  such that the two surfaces are now connected.
-CORKLIBRARY_API void resolveIntersections(CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out);
+CORKLIBRARY_API bool resolveIntersections(CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out);
+CORKLIBRARY_API bool resolveIntersections(CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out,
+                                          const CorkOptions &options);
+
+// An operand used in many operations, such as a tool subtracted from
+// many parts, can be prepared once instead of being converted again
+// by every operation.  Preparing also bounds the mesh, finds its
+// connected components and builds a bounding volume hierarchy of its
+// triangles, which the operations, intersects() and classify() reuse;
+// only the work that involves both operands is done each time.
+// The handle also remembers the answer to isSolid().
+// Operations never modify a prepared mesh, so it may be shared by
+// several threads at once.
+struct CorkPreparedMesh;
+
+CORKLIBRARY_API CorkPreparedMesh* prepareCorkMesh(CorkTriMesh mesh);
+CORKLIBRARY_API void freeCorkPreparedMesh(CorkPreparedMesh *mesh);
+
+// as isSolid() above; only the first call does any work
+CORKLIBRARY_API bool isSolid(CorkPreparedMesh *mesh);
+
+// the operations above, on prepared operands
+CORKLIBRARY_API bool computeUnion(const CorkPreparedMesh *in0, const CorkPreparedMesh *in1,
+                                  CorkTriMesh *out);
+CORKLIBRARY_API bool computeUnion(const CorkPreparedMesh *in0, const CorkPreparedMesh *in1,
+                                  CorkTriMesh *out, const CorkOptions &options);
+CORKLIBRARY_API bool computeDifference(const CorkPreparedMesh *in0, const CorkPreparedMesh *in1,
+                                       CorkTriMesh *out);
+CORKLIBRARY_API bool computeDifference(const CorkPreparedMesh *in0, const CorkPreparedMesh *in1,
+                                       CorkTriMesh *out, const CorkOptions &options);
+CORKLIBRARY_API bool computeIntersection(const CorkPreparedMesh *in0, const CorkPreparedMesh *in1,
+                                         CorkTriMesh *out);
+CORKLIBRARY_API bool computeIntersection(const CorkPreparedMesh *in0, const CorkPreparedMesh *in1,
+                                         CorkTriMesh *out, const CorkOptions &options);
+CORKLIBRARY_API bool computeSymmetricDifference(const CorkPreparedMesh *in0, const CorkPreparedMesh *in1,
+                                                CorkTriMesh *out);
+CORKLIBRARY_API bool computeSymmetricDifference(const CorkPreparedMesh *in0, const CorkPreparedMesh *in1,
+                                                CorkTriMesh *out, const CorkOptions &options);
+CORKLIBRARY_API bool resolveIntersections(const CorkPreparedMesh *in0, const CorkPreparedMesh *in1,
+                                          CorkTriMesh *out);
+CORKLIBRARY_API bool resolveIntersections(const CorkPreparedMesh *in0, const CorkPreparedMesh *in1,
+                                          CorkTriMesh *out, const CorkOptions &options);
+
+// result = in[0] U in[1] U ... U in[n-1]
+//  The intersections between all of the inputs are resolved at once,
+//  which is much faster than folding computeUnion() over many inputs.
+//  The cross_operand_only and overlap_only options only apply to
+//  two inputs, and are ignored here.
+CORKLIBRARY_API bool computeNaryUnion(const CorkTriMesh *in, uint n, CorkTriMesh *out);
+CORKLIBRARY_API bool computeNaryUnion(const CorkTriMesh *in, uint n, CorkTriMesh *out,
+                                      const CorkOptions &options);
+CORKLIBRARY_API bool computeNaryUnion(const CorkPreparedMesh *const *in, uint n,
+                                      CorkTriMesh *out);
+CORKLIBRARY_API bool computeNaryUnion(const CorkPreparedMesh *const *in, uint n,
+                                      CorkTriMesh *out, const CorkOptions &options);
+
+// one node of a CSG expression, for computeCsg() below.
+// Nodes refer to their children by index into the node array,
+// and every node comes after its children, so the last one is the root
+struct CorkCsgNode
+{
+    enum Op { OPERAND, UNION, DIFFERENCE, INTERSECTION, SYMMETRIC_DIFFERENCE };
+    Op      op;
+    uint    operand;    // OPERAND nodes: index of the input mesh
+    uint    left;       // the other nodes: indices of the two children;
+    uint    right;      // DIFFERENCE computes left - right
+};
+
+// result = the expression nodes[n_nodes-1] over in[0] ... in[n_in-1]
+//  e.g. (A U B) - C is { {OPERAND,0}, {OPERAND,1}, {UNION,0,0,1},
+//  {OPERAND,2}, {DIFFERENCE,0,2,3} }.  The intersections between all
+//  of the inputs used are resolved at once, and then each piece of
+//  the surface is kept or not according to the whole expression,
+//  rather than computing an intermediate mesh for every node.
+//  Returns false, leaving out untouched, if the nodes don't form an
+//  expression as described above, or as the Boolean operations do.
+//  Options as for computeNaryUnion()
+CORKLIBRARY_API bool computeCsg(const CorkTriMesh *in, uint n_in,
+                                const CorkCsgNode *nodes, uint n_nodes,
+                                CorkTriMesh *out);
+CORKLIBRARY_API bool computeCsg(const CorkTriMesh *in, uint n_in,
+                                const CorkCsgNode *nodes, uint n_nodes,
+                                CorkTriMesh *out, const CorkOptions &options);
+CORKLIBRARY_API bool computeCsg(const CorkPreparedMesh *const *in, uint n_in,
+                                const CorkCsgNode *nodes, uint n_nodes,
+                                CorkTriMesh *out);
+CORKLIBRARY_API bool computeCsg(const CorkPreparedMesh *const *in, uint n_in,
+                                const CorkCsgNode *nodes, uint n_nodes,
+                                CorkTriMesh *out, const CorkOptions &options);
+
+// how two solids are arranged; see classify() below
+enum CorkNesting
+{
+    CORK_INTERSECTING,  // the surfaces intersect or touch
+    CORK_APART,         // neither contains the other
+    CORK_IN0_IN_IN1,    // in0 lies inside in1
+    CORK_IN1_IN_IN0,    // in1 lies inside in0
+    CORK_PARTLY_INSIDE  // some, but not all, of the connected components
+                        // of in0 or in1 lie inside the other solid
+};
+
+// Do the surfaces of in0 and in1 intersect (or touch)?
+//  Much faster than any of the operations above: nothing is resolved,
+//  no output is built, and the search stops at the first intersection
+//  found.  For many queries on the same meshes, prepare them first.
+CORKLIBRARY_API bool intersects(CorkTriMesh in0, CorkTriMesh in1);
+CORKLIBRARY_API bool intersects(const CorkPreparedMesh *in0,
+                                const CorkPreparedMesh *in1);
+// as intersects(), and if they don't, whether one contains the other.
+//  That takes one inside test per connected component
+CORKLIBRARY_API CorkNesting classify(CorkTriMesh in0, CorkTriMesh in1);
+CORKLIBRARY_API CorkNesting classify(const CorkPreparedMesh *in0,
+                                     const CorkPreparedMesh *in1);
+
+// polylines, e.g. the curves along which two surfaces intersect.
+// Curve k is made of the points curve_starts[k] up to curve_starts[k+1];
+// a closed curve doesn't repeat its first point at the end.
+// Please use the provided function to free the allocated memory.
+struct CorkPolylines
+{
+    uint    n_curves;
+    uint    n_points;
+    uint    *curve_starts;  // n_curves+1 entries
+    bool    *closed;        // whether curve k's last point joins its first
+    float   *points;        // 3 coordinates per point
+};
+
+CORKLIBRARY_API void freeCorkPolylines(CorkPolylines *curves);
+
+// the curves along which the surfaces of in0 and in1 intersect
+//  Only the intersections are found; nothing is resolved or removed,
+//  so this is much faster than any of the operations above.
+//  A curve is split into separate polylines where curves branch.
+//  Returns false, leaving out untouched, as the Boolean operations do
+CORKLIBRARY_API bool computeIntersectionCurves(CorkTriMesh in0, CorkTriMesh in1,
+                                               CorkPolylines *out);
+CORKLIBRARY_API bool computeIntersectionCurves(CorkTriMesh in0, CorkTriMesh in1,
+                                               CorkPolylines *out,
+                                               const CorkOptions &options);
+CORKLIBRARY_API bool computeIntersectionCurves(const CorkPreparedMesh *in0,
+                                               const CorkPreparedMesh *in1,
+                                               CorkPolylines *out);
+CORKLIBRARY_API bool computeIntersectionCurves(const CorkPreparedMesh *in0,
+                                               const CorkPreparedMesh *in1,
+                                               CorkPolylines *out,
+                                               const CorkOptions &options);
 
 CORKLIBRARY_API void translateZ(CorkTriMesh& in0, float deltaZ);
 CORKLIBRARY_API void rotate180X(CorkTriMesh& in0);
@@ -149,7 +149,7 @@ namespace Files {
         fwrite(&size, sizeof(size), 1, f);
 
         StlTriangle triangle;
-        triangle.normal.n[0] = triangle.normal.n[2] = triangle.normal.n[2] = 0;
+        triangle.normal.n[0] = triangle.normal.n[1] = triangle.normal.n[2] = 0;
         triangle.attributeByteCount = 0;
         for (auto iter = data->triangles.cbegin(); iter != data->triangles.cend(); iter++) {
             fillTriangleWithVertex(triangle.v1, data->vertices[iter->a].pos);
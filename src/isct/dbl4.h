@@ -0,0 +1,184 @@
+// +-------------------------------------------------------------------------
+// | dbl4.h
+// | 
+// | Author: Gilbert Bernstein
+// +-------------------------------------------------------------------------
+// | COPYRIGHT:
+// |    Copyright Gilbert Bernstein 2013
+// |    See the included COPYRIGHT file for further details.
+// |    
+// |    This file is part of the Cork library.
+// |
+// |    Cork is free software: you can redistribute it and/or modify
+// |    it under the terms of the GNU Lesser General Public License as
+// |    published by the Free Software Foundation, either version 3 of
+// |    the License, or (at your option) any later version.
+// |
+// |    Cork is distributed in the hope that it will be useful,
+// |    but WITHOUT ANY WARRANTY; without even the implied warranty of
+// |    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// |    GNU Lesser General Public License for more details.
+// |
+// |    You should have received a copy 
+// |    of the GNU Lesser General Public License
+// |    along with Cork.  If not, see <http://www.gnu.org/licenses/>.
+// +-------------------------------------------------------------------------
+#pragma once
+
+/*
+ *
+ *  Dbl4
+ *
+ *      A pack of 4 doubles with lane-wise arithmetic, for evaluating
+ *      the same floating point expression on 4 inputs at once.
+ *
+ *      Uses AVX when the compiler targets it (e.g. -mavx2), otherwise
+ *      a pair of SSE2 registers, otherwise plain scalar code.
+ *      All three give bit-identical results to the equivalent
+ *      scalar double computation.
+ *
+ */
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define DBL4_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || \
+      (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DBL4_SSE2
+#endif
+
+#include <cmath>
+
+struct Dbl4
+{
+#if defined(DBL4_AVX)
+    __m256d v;
+#elif defined(DBL4_SSE2)
+    __m128d lo, hi;
+#else
+    double  v[4];
+#endif
+    
+    inline Dbl4() {}
+    // the same value in every lane
+    inline explicit Dbl4(double x) {
+#if defined(DBL4_AVX)
+        v  = _mm256_set1_pd(x);
+#elif defined(DBL4_SSE2)
+        lo = hi = _mm_set1_pd(x);
+#else
+        v[0] = v[1] = v[2] = v[3] = x;
+#endif
+    }
+    inline Dbl4(double x0, double x1, double x2, double x3) {
+#if defined(DBL4_AVX)
+        v  = _mm256_set_pd(x3, x2, x1, x0);
+#elif defined(DBL4_SSE2)
+        lo = _mm_set_pd(x1, x0);
+        hi = _mm_set_pd(x3, x2);
+#else
+        v[0] = x0;  v[1] = x1;  v[2] = x2;  v[3] = x3;
+#endif
+    }
+    
+    inline void store(double out[4]) const {
+#if defined(DBL4_AVX)
+        _mm256_storeu_pd(out, v);
+#elif defined(DBL4_SSE2)
+        _mm_storeu_pd(out,     lo);
+        _mm_storeu_pd(out + 2, hi);
+#else
+        for(int i=0; i<4; i++)
+            out[i] = v[i];
+#endif
+    }
+};
+
+#if defined(DBL4_AVX)
+#define DBL4_BINOP(op, intrinsic) \
+    inline Dbl4 operator op(const Dbl4 &a, const Dbl4 &b) { \
+        Dbl4 r;     r.v = intrinsic(a.v, b.v);      return r; \
+    }
+DBL4_BINOP(+, _mm256_add_pd)
+DBL4_BINOP(-, _mm256_sub_pd)
+DBL4_BINOP(*, _mm256_mul_pd)
+#elif defined(DBL4_SSE2)
+#define DBL4_BINOP(op, intrinsic) \
+    inline Dbl4 operator op(const Dbl4 &a, const Dbl4 &b) { \
+        Dbl4 r;     r.lo = intrinsic(a.lo, b.lo); \
+                    r.hi = intrinsic(a.hi, b.hi);   return r; \
+    }
+DBL4_BINOP(+, _mm_add_pd)
+DBL4_BINOP(-, _mm_sub_pd)
+DBL4_BINOP(*, _mm_mul_pd)
+#else
+#define DBL4_BINOP(op, unused) \
+    inline Dbl4 operator op(const Dbl4 &a, const Dbl4 &b) { \
+        Dbl4 r; \
+        for(int i=0; i<4; i++)  r.v[i] = a.v[i] op b.v[i]; \
+        return r; \
+    }
+DBL4_BINOP(+, _)
+DBL4_BINOP(-, _)
+DBL4_BINOP(*, _)
+#endif
+#undef DBL4_BINOP
+
+// negation and absolute value just flip or clear the sign bits
+inline Dbl4 operator-(const Dbl4 &a) {
+    Dbl4 r;
+#if defined(DBL4_AVX)
+    r.v  = _mm256_xor_pd(a.v, _mm256_set1_pd(-0.0));
+#elif defined(DBL4_SSE2)
+    r.lo = _mm_xor_pd(a.lo, _mm_set1_pd(-0.0));
+    r.hi = _mm_xor_pd(a.hi, _mm_set1_pd(-0.0));
+#else
+    for(int i=0; i<4; i++)  r.v[i] = -a.v[i];
+#endif
+    return r;
+}
+inline Dbl4 fabs(const Dbl4 &a) {
+    Dbl4 r;
+#if defined(DBL4_AVX)
+    r.v  = _mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v);
+#elif defined(DBL4_SSE2)
+    r.lo = _mm_andnot_pd(_mm_set1_pd(-0.0), a.lo);
+    r.hi = _mm_andnot_pd(_mm_set1_pd(-0.0), a.hi);
+#else
+    for(int i=0; i<4; i++)  r.v[i] = std::fabs(a.v[i]);
+#endif
+    return r;
+}
+
+// bit i of the result is set when lane i of a is less than lane i of b
+inline int lessMask(const Dbl4 &a, const Dbl4 &b) {
+#if defined(DBL4_AVX)
+    return _mm256_movemask_pd(_mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ));
+#elif defined(DBL4_SSE2)
+    return  _mm_movemask_pd(_mm_cmplt_pd(a.lo, b.lo)) |
+           (_mm_movemask_pd(_mm_cmplt_pd(a.hi, b.hi)) << 2);
+#else
+    int mask = 0;
+    for(int i=0; i<4; i++)
+        if(a.v[i] < b.v[i])     mask |= 1 << i;
+    return mask;
+#endif
+}
+
+// lane i of the result is -a when bit i of mask is set, a otherwise
+inline Dbl4 negateLanes(const Dbl4 &a, int mask) {
+    Dbl4 sign(  (mask & 1)? -0.0 : 0.0,     (mask & 2)? -0.0 : 0.0,
+                (mask & 4)? -0.0 : 0.0,     (mask & 8)? -0.0 : 0.0  );
+    Dbl4 r;
+#if defined(DBL4_AVX)
+    r.v  = _mm256_xor_pd(a.v, sign.v);
+#elif defined(DBL4_SSE2)
+    r.lo = _mm_xor_pd(a.lo, sign.lo);
+    r.hi = _mm_xor_pd(a.hi, sign.hi);
+#else
+    for(int i=0; i<4; i++)
+        r.v[i] = ((mask >> i) & 1)? -a.v[i] : a.v[i];
+#endif
+    return r;
+}
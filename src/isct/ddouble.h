@@ -0,0 +1,126 @@
+// +-------------------------------------------------------------------------
+// | ddouble.h
+// | 
+// | Author: Gilbert Bernstein
+// +-------------------------------------------------------------------------
+// | COPYRIGHT:
+// |    Copyright Gilbert Bernstein 2013
+// |    See the included COPYRIGHT file for further details.
+// |    
+// |    This file is part of the Cork library.
+// |
+// |    Cork is free software: you can redistribute it and/or modify
+// |    it under the terms of the GNU Lesser General Public License as
+// |    published by the Free Software Foundation, either version 3 of
+// |    the License, or (at your option) any later version.
+// |
+// |    Cork is distributed in the hope that it will be useful,
+// |    but WITHOUT ANY WARRANTY; without even the implied warranty of
+// |    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// |    GNU Lesser General Public License for more details.
+// |
+// |    You should have received a copy 
+// |    of the GNU Lesser General Public License
+// |    along with Cork.  If not, see <http://www.gnu.org/licenses/>.
+// +-------------------------------------------------------------------------
+#pragma once
+
+/*
+ *
+ *  DDouble
+ *
+ *      Double-double numbers: an unevaluated sum hi + lo of two
+ *      doubles with |lo| <= ulp(hi)/2, giving about 106 bits of
+ *      precision.  Built from the error-free transformations
+ *      (two-sum, two-product) of Dekker, Knuth and Shewchuk,
+ *      without relying on fused multiply-add.
+ *
+ *      Sums and products of double-doubles have a relative error
+ *      of at most a small multiple of 2^-106; see DDOUBLE_EPS.
+ *
+ */
+
+#include <cfloat>
+
+// a bound on the relative error of a single + - or * below
+#define DDOUBLE_EPS (8.0 * DBL_EPSILON * DBL_EPSILON)
+
+struct DDouble
+{
+    double hi, lo;
+    
+    inline DDouble() {}
+    inline DDouble(double x) : hi(x), lo(0.0) {}
+    inline DDouble(double h, double l) : hi(h), lo(l) {}
+};
+
+namespace DDoubleDetail {
+
+// s + err == a + b exactly, if |a| >= |b|
+inline void quickTwoSum(double a, double b, double &s, double &err)
+{
+    s   = a + b;
+    err = b - (s - a);
+}
+
+// s + err == a + b exactly
+inline void twoSum(double a, double b, double &s, double &err)
+{
+    s   = a + b;
+    double bb = s - a;
+    err = (a - (s - bb)) + (b - bb);
+}
+
+// hi + lo == a, each with at most 26 significant bits
+inline void split(double a, double &hi, double &lo)
+{
+    const double SPLITTER = 134217729.0; // 2^27 + 1
+    double c = SPLITTER * a;
+    hi = c - (c - a);
+    lo = a - hi;
+}
+
+// p + err == a * b exactly
+inline void twoProd(double a, double b, double &p, double &err)
+{
+    double ahi, alo, bhi, blo;
+    p = a * b;
+    split(a, ahi, alo);
+    split(b, bhi, blo);
+    err = ((ahi * bhi - p) + ahi * blo + alo * bhi) + alo * blo;
+}
+
+} // end namespace DDoubleDetail
+
+inline DDouble operator-(const DDouble &a)
+{
+    return DDouble(-a.hi, -a.lo);
+}
+
+inline DDouble operator+(const DDouble &a, const DDouble &b)
+{
+    using namespace DDoubleDetail;
+    double s1, s2, t1, t2;
+    twoSum(a.hi, b.hi, s1, s2);
+    twoSum(a.lo, b.lo, t1, t2);
+    s2 += t1;
+    quickTwoSum(s1, s2, s1, s2);
+    s2 += t2;
+    quickTwoSum(s1, s2, s1, s2);
+    return DDouble(s1, s2);
+}
+
+inline DDouble operator-(const DDouble &a, const DDouble &b)
+{
+    return a + (-b);
+}
+
+inline DDouble operator*(const DDouble &a, const DDouble &b)
+{
+    using namespace DDoubleDetail;
+    double p1, p2;
+    twoProd(a.hi, b.hi, p1, p2);
+    p2 += a.hi * b.lo + a.lo * b.hi;
+    quickTwoSum(p1, p2, p1, p2);
+    return DDouble(p1, p2);
+}
@@ -28,23 +28,21 @@
 #include "ext4.h"
 #include "absext4.h"
 #include "fixext4.h"
-#include "gmpext4.h"
+#include "genext4.h"
+#include "dbl4.h"
+#include "ddouble.h"
 
 #include "quantization.h"
 
+#include <algorithm>
 #include <cfloat>
 
 namespace Empty3d {
 
-// externalized counters...
-int degeneracy_count = 0;
-int exact_count = 0;
-int callcount = 0;
-
 using namespace Ext4;
 using namespace AbsExt4;
 using namespace FixExt4;
-using namespace GMPExt4;
+using namespace GenExt4;
 
 void toExt(Ext4_1 &out, const Vec3d &in)
 {
@@ -73,32 +71,27 @@ void toVec3d(Vec3d &out, const Ext4_1 &in)
 
 const static int IN_BITS = Quantization::BITS + 1; // +1 for sign bit
 
-void toFixExt(FixExt4_1<IN_BITS> &out, const Vec3d &in)
+void toFixExt(FixExt4_1<IN_BITS> &out, const Vec3d &in,
+              const Quantization::Quantizer &quantizer)
 {
-    out.e0 = BitInt<IN_BITS>::Rep(Quantization::quantize2int(in[0]));
-    out.e1 = BitInt<IN_BITS>::Rep(Quantization::quantize2int(in[1]));
-    out.e2 = BitInt<IN_BITS>::Rep(Quantization::quantize2int(in[2]));
+    out.e0 = BitInt<IN_BITS>::Rep(quantizer.quantize2int(in[0]));
+    out.e1 = BitInt<IN_BITS>::Rep(quantizer.quantize2int(in[1]));
+    out.e2 = BitInt<IN_BITS>::Rep(quantizer.quantize2int(in[2]));
     out.e3 = BitInt<IN_BITS>::Rep(1);
 }
 
-void toGmpExt(GmpExt4_1 &out, const Vec3d &in)
-{
-    out.e0 = Quantization::quantize2int(in.x);
-    out.e1 = Quantization::quantize2int(in.y);
-    out.e2 = Quantization::quantize2int(in.z);
-    out.e3 = 1;
-}
-
-void toVec3d(Vec3d &out, const GmpExt4_1 &in)
+template<int BITS>
+void toVec3d(Vec3d &out, const FixExt4_1<BITS> &in,
+             const Quantization::Quantizer &quantizer)
 {
     Vec4d tmp;
-    tmp.x = in.e0.get_d();
-    tmp.y = in.e1.get_d();
-    tmp.z = in.e2.get_d();
-    tmp.w = in.e3.get_d();
+    tmp.x = toDouble(in.e0);
+    tmp.y = toDouble(in.e1);
+    tmp.z = toDouble(in.e2);
+    tmp.w = toDouble(in.e3);
     tmp /= tmp.w;
     for(uint k=0; k<3; k++)
-        out.v[k] = Quantization::RESHRINK * tmp.v[k];
+        out.v[k] = quantizer.reshrink() * tmp.v[k];
 }
 
 //template<int BITS>
@@ -124,10 +117,35 @@ inline bool filterCheck(double val, double absval, double coeff) {
     return fabs(val) > absval*coeff;
 }
 
+// The double-double stage redoes a filter at roughly twice the
+// precision.  It runs only when the double filter is uncertain, and
+// most near-degenerate queries are settled here instead of with the
+// much slower wide integer fallbacks.
+// The magnitude bounds are still computed in plain double; doubling
+// the coefficients more than covers their rounding error.
+const static double DDEPS               = DDOUBLE_EPS;
+const static double DDEPS2              = DDEPS * DDEPS;
+
+typedef GenExt4_1<DDouble>  DDExt4_1;       typedef GenExt4_1<double> DKExt4_1;
+typedef GenExt4_2<DDouble>  DDExt4_2;       typedef GenExt4_2<double> DKExt4_2;
+typedef GenExt4_3<DDouble>  DDExt4_3;       typedef GenExt4_3<double> DKExt4_3;
+
+void toDDExt(DDExt4_1 &out, DKExt4_1 &kout, const Vec3d &in)
+{
+    out.e0 = in.x;          kout.e0 = fabs(in.x);
+    out.e1 = in.y;          kout.e1 = fabs(in.y);
+    out.e2 = in.z;          kout.e2 = fabs(in.z);
+    out.e3 = 1.0;           kout.e3 = 1.0;
+}
+
+inline bool filterCheck(const DDouble &val, double absval, double coeff) {
+    return fabs(val.hi) > absval*coeff;
+}
+
 
-bool isEmpty(const TriEdgeIn &input)
+bool isEmpty(const TriEdgeIn &input, ExactArithmeticContext *ctxt)
 {
-    callcount++;
+    ctxt->callcount++;
     
     Ext4_2 temp_e2;
     
@@ -207,29 +225,40 @@ const static double COEFF_IT12_PISCT    = 10.0*EPS + 64.0*EPS2;
 const static double COEFF_IT12_S1       = 20.0*EPS + 256.0*EPS2;
 const static double COEFF_IT12_S2       = 24.0*EPS + 512.0*EPS2;
 
-int emptyFilter(const TriEdgeIn &input)
+void prepare(PreparedTri &prep, const TriIn &input)
 {
     Ext4_2 temp2;                           AbsExt4_2 ktemp2;
-    Ext4_1 ep[2];                           AbsExt4_1 kep[2];
-    Ext4_1 tp[3];                           AbsExt4_1 ktp[3];
-    Ext4_2 e_ext2;                          AbsExt4_2 ke_ext2;
-    Ext4_3 t_ext3;                          AbsExt4_3 kt_ext3;
     
-    // load the points
-    for(int i=0; i<2; i++) {
-        toExt(ep[i], input.edge.p[i]);      abs(kep[i], ep[i]);
-    }
+    prep.in = input;
     for(int i=0; i<3; i++) {
-        toExt(tp[i], input.tri.p[i]);       abs(ktp[i], tp[i]);
+        toExt(prep.p[i], input.p[i]);       abs(prep.kp[i], prep.p[i]);
     }
-    // form the edge and triangle
-    join(e_ext2, ep[0], ep[1]);             join(ke_ext2, kep[0], kep[1]);
-    join(temp2,  tp[0], tp[1]);             join(ktemp2,  ktp[0], ktp[1]);
-    join(t_ext3, temp2, tp[2]);             join(kt_ext3, ktemp2, ktp[2]);
+    join(temp2, prep.p[0], prep.p[1]);      join(ktemp2, prep.kp[0],
+                                                         prep.kp[1]);
+    join(prep.plane, temp2, prep.p[2]);     join(prep.kplane, ktemp2,
+                                                              prep.kp[2]);
+}
+
+void prepare(PreparedEdge &prep, const EdgeIn &input)
+{
+    prep.in = input;
+    for(int i=0; i<2; i++) {
+        toExt(prep.p[i], input.p[i]);       abs(prep.kp[i], prep.p[i]);
+    }
+    join(prep.line, prep.p[0], prep.p[1]);  join(prep.kline, prep.kp[0],
+                                                             prep.kp[1]);
+}
+
+int emptyFilter(const PreparedTri &tri, const PreparedEdge &edge)
+{
+    Ext4_2 temp2;                           AbsExt4_2 ktemp2;
+    const Ext4_1 *ep = edge.p;              const AbsExt4_1 *kep = edge.kp;
+    const Ext4_1 *tp = tri.p;               const AbsExt4_1 *ktp = tri.kp;
     
     // compute the point of intersection
     Ext4_1 pisct;                           AbsExt4_1 kpisct;
-    meet(pisct, e_ext2, t_ext3);            meet(kpisct, ke_ext2, kt_ext3);
+    meet(pisct, edge.line, tri.plane);      meet(kpisct, edge.kline,
+                                                         tri.kplane);
     // We perform one of the filter exit tests here...
     if(!filterCheck(pisct.e3, kpisct.e3, COEFF_IT12_PISCT))
         return 0; // i.e. uncertain
@@ -245,7 +274,8 @@ int emptyFilter(const TriEdgeIn &input)
                 (i==1)? pisct : ep[1]);
                                             join(ka, (i==0)? kpisct : kep[0],
                                                      (i==1)? kpisct : kep[1]);
-        double dot = inner(e_ext2, a);      double kdot = inner(ke_ext2, ka);
+        double dot = inner(edge.line, a);   double kdot = inner(edge.kline,
+                                                                ka);
         // now figure out what to do...
             bool outside = dot < 0.0;
             bool reliable = filterCheck(dot, kdot, COEFF_IT12_S1);
@@ -264,7 +294,8 @@ int emptyFilter(const TriEdgeIn &input)
                                                  (i==1)? kpisct : ktp[1]);
                                     join(ka,     ktemp2,
                                                  (i==2)? kpisct : ktp[2]);
-        double dot = inner(t_ext3, a);      double kdot = inner(kt_ext3, ka);
+        double dot = inner(tri.plane, a);   double kdot = inner(tri.kplane,
+                                                                ka);
         // now figure out what to do...
             bool outside = dot < 0.0;
             bool reliable = filterCheck(dot, kdot, COEFF_IT12_S2);
@@ -278,7 +309,199 @@ int emptyFilter(const TriEdgeIn &input)
         return -1; // i.e. false (the intersection is not empty)
 }
 
-bool exactFallback(const TriEdgeIn &input)
+int emptyFilter(const TriEdgeIn &input)
+{
+    PreparedTri     tri;
+    PreparedEdge    edge;
+    prepare(tri, input.tri);
+    prepare(edge, input.edge);
+    return emptyFilter(tri, edge);
+}
+
+const static double COEFF_DD_IT12_PISCT = 2.0*(10.0*DDEPS + 64.0*DDEPS2);
+const static double COEFF_DD_IT12_S1    = 2.0*(20.0*DDEPS + 256.0*DDEPS2);
+const static double COEFF_DD_IT12_S2    = 2.0*(24.0*DDEPS + 512.0*DDEPS2);
+
+int emptyFilterDD(const TriEdgeIn &input)
+{
+    DDExt4_2 temp2;                         DKExt4_2 ktemp2;
+    DDExt4_1 ep[2];                         DKExt4_1 kep[2];
+    DDExt4_1 tp[3];                         DKExt4_1 ktp[3];
+    DDExt4_2 e_ext2;                        DKExt4_2 ke_ext2;
+    DDExt4_3 t_ext3;                        DKExt4_3 kt_ext3;
+    
+    // load the points
+    for(int i=0; i<2; i++)
+        toDDExt(ep[i], kep[i], input.edge.p[i]);
+    for(int i=0; i<3; i++)
+        toDDExt(tp[i], ktp[i], input.tri.p[i]);
+    // form the edge and triangle
+    join(e_ext2, ep[0], ep[1]);             absJoin(ke_ext2, kep[0], kep[1]);
+    join(temp2,  tp[0], tp[1]);             absJoin(ktemp2,  ktp[0], ktp[1]);
+    join(t_ext3, temp2, tp[2]);             absJoin(kt_ext3, ktemp2, ktp[2]);
+    
+    // compute the point of intersection
+    DDExt4_1 pisct;                         DKExt4_1 kpisct;
+    meet(pisct, e_ext2, t_ext3);            absMeet(kpisct, ke_ext2, kt_ext3);
+    if(!filterCheck(pisct.e3, kpisct.e3, COEFF_DD_IT12_PISCT))
+        return 0; // i.e. uncertain
+    // need to adjust for negative w-coordinate
+    if(pisct.e3.hi < 0.0)
+        neg(pisct, pisct);
+    
+    bool uncertain = false;
+    // process edge
+    for(int i=0; i<2; i++) {
+        DDExt4_2 a;                         DKExt4_2 ka;
+        join(a, (i==0)? pisct : ep[0],
+                (i==1)? pisct : ep[1]);
+                                        absJoin(ka, (i==0)? kpisct : kep[0],
+                                                    (i==1)? kpisct : kep[1]);
+        DDouble dot = inner(e_ext2, a);     double kdot = inner(ke_ext2, ka);
+            bool outside = dot.hi < 0.0;
+            bool reliable = filterCheck(dot, kdot, COEFF_DD_IT12_S1);
+            if(reliable && outside)
+                return 1; // i.e. true
+            if(!reliable)   uncertain = true;
+    }
+    // process triangle
+    for(int i=0; i<3; i++) {
+        DDExt4_3 a;                         DKExt4_3 ka;
+        join(temp2, (i==0)? pisct : tp[0],
+                    (i==1)? pisct : tp[1]);
+        join(a,     temp2,
+                    (i==2)? pisct : tp[2]);
+                                absJoin(ktemp2, (i==0)? kpisct : ktp[0],
+                                                (i==1)? kpisct : ktp[1]);
+                                absJoin(ka,     ktemp2,
+                                                (i==2)? kpisct : ktp[2]);
+        DDouble dot = inner(t_ext3, a);     double kdot = inner(kt_ext3, ka);
+            bool outside = dot.hi < 0.0;
+            bool reliable = filterCheck(dot, kdot, COEFF_DD_IT12_S2);
+            if(reliable && outside)
+                return 1; // i.e. true
+            if(!reliable)   uncertain = true;
+    }
+    if(uncertain)
+        return 0;
+    else
+        return -1; // i.e. false (the intersection is not empty)
+}
+
+// Pull the same k-vector out of 4 different prepared pairs,
+// given pointers to each one's coordinate array
+inline Dbl4 lane(const double * const v[4], int i)
+{
+    return Dbl4(v[0][i], v[1][i], v[2][i], v[3][i]);
+}
+inline void gather(GenExt4_1<Dbl4> &out, const double * const v[4])
+{
+    out.e0  = lane(v,0);    out.e1  = lane(v,1);
+    out.e2  = lane(v,2);    out.e3  = lane(v,3);
+}
+inline void gather(GenExt4_2<Dbl4> &out, const double * const v[4])
+{
+    out.e01 = lane(v,0);    out.e02 = lane(v,1);    out.e03 = lane(v,2);
+    out.e12 = lane(v,3);    out.e13 = lane(v,4);    out.e23 = lane(v,5);
+}
+inline void gather(GenExt4_3<Dbl4> &out, const double * const v[4])
+{
+    out.e012 = lane(v,0);   out.e013 = lane(v,1);
+    out.e023 = lane(v,2);   out.e123 = lane(v,3);
+}
+
+// The filter above, for 4 pairs at once.
+// Every test is evaluated for every pair, and then the per-test
+// outcomes are combined exactly as the scalar version would.
+void emptyFilter4(const PreparedTri * const tris[4],
+                  const PreparedEdge * const edges[4],
+                  int result[4])
+{
+    typedef GenExt4_1<Dbl4> V1;
+    typedef GenExt4_2<Dbl4> V2;
+    typedef GenExt4_3<Dbl4> V3;
+    const double *ptrs[4];
+    
+    // transpose the inputs into lanes
+    V1 ep[2], kep[2], tp[3], ktp[3];
+    V2 line, kline;
+    V3 plane, kplane;
+    for(int i=0; i<2; i++) {
+        for(int l=0; l<4; l++)  ptrs[l] = edges[l]->p[i].v;
+        gather(ep[i], ptrs);
+        for(int l=0; l<4; l++)  ptrs[l] = edges[l]->kp[i].v;
+        gather(kep[i], ptrs);
+    }
+    for(int l=0; l<4; l++)      ptrs[l] = edges[l]->line.v;
+    gather(line, ptrs);
+    for(int l=0; l<4; l++)      ptrs[l] = edges[l]->kline.v;
+    gather(kline, ptrs);
+    for(int l=0; l<4; l++)      ptrs[l] = tris[l]->plane.v;
+    gather(plane, ptrs);
+    for(int l=0; l<4; l++)      ptrs[l] = tris[l]->kplane.v;
+    gather(kplane, ptrs);
+    
+    // compute the point of intersection
+    V1 pisct, kpisct;
+    meet(pisct, line, plane);
+    absMeet(kpisct, kline, kplane);
+    int pisct_ok = lessMask(kpisct.e3 * Dbl4(COEFF_IT12_PISCT),
+                            fabs(pisct.e3));
+    // need to adjust for negative w-coordinate
+    int flip = lessMask(pisct.e3, Dbl4(0.0));
+    pisct.e0 = negateLanes(pisct.e0, flip);
+    pisct.e1 = negateLanes(pisct.e1, flip);
+    pisct.e2 = negateLanes(pisct.e2, flip);
+    pisct.e3 = negateLanes(pisct.e3, flip);
+    
+    int outside     = 0; // certainly outside one of the simplices
+    int uncertain   = 0;
+    auto test = [&](const Dbl4 &dot, const Dbl4 &kdot, double coeff) {
+        int reliable = lessMask(kdot * Dbl4(coeff), fabs(dot));
+        outside     |= reliable & lessMask(dot, Dbl4(0.0));
+        uncertain   |= ~reliable & 0xF;
+    };
+    
+    // process edge
+    V2 a2, ka2;
+    join(a2, pisct, ep[1]);             absJoin(ka2, kpisct, kep[1]);
+    test(inner(line, a2), inner(kline, ka2), COEFF_IT12_S1);
+    join(a2, ep[0], pisct);             absJoin(ka2, kep[0], kpisct);
+    test(inner(line, a2), inner(kline, ka2), COEFF_IT12_S1);
+    
+    // Most candidates miss the edge's span.
+    // Skip the rest once every lane's outcome is settled
+    int settled = ~pisct_ok | outside;
+    if((settled & 0xF) != 0xF) {
+        for(int i=0; i<3; i++) {
+            for(int l=0; l<4; l++)  ptrs[l] = tris[l]->p[i].v;
+            gather(tp[i], ptrs);
+            for(int l=0; l<4; l++)  ptrs[l] = tris[l]->kp[i].v;
+            gather(ktp[i], ptrs);
+        }
+    
+        // process triangle
+        V3 a3, ka3;
+        join(a2, pisct, tp[1]);             absJoin(ka2, kpisct, ktp[1]);
+        join(a3, a2, tp[2]);                absJoin(ka3, ka2, ktp[2]);
+        test(inner(plane, a3), inner(kplane, ka3), COEFF_IT12_S2);
+        join(a2, tp[0], pisct);             absJoin(ka2, ktp[0], kpisct);
+        join(a3, a2, tp[2]);                absJoin(ka3, ka2, ktp[2]);
+        test(inner(plane, a3), inner(kplane, ka3), COEFF_IT12_S2);
+        join(a2, tp[0], tp[1]);             absJoin(ka2, ktp[0], ktp[1]);
+        join(a3, a2, pisct);                absJoin(ka3, ka2, kpisct);
+        test(inner(plane, a3), inner(kplane, ka3), COEFF_IT12_S2);
+    }
+    
+    for(int l=0; l<4; l++) {
+        if(!((pisct_ok >> l) & 1))      result[l] = 0;
+        else if((outside >> l) & 1)     result[l] = 1;
+        else if((uncertain >> l) & 1)   result[l] = 0;
+        else                            result[l] = -1;
+    }
+}
+
+bool exactFallback(const TriEdgeIn &input, ExactArithmeticContext *ctxt)
 {
     // How many bits do we need for various intermediary values?
     // Here we label the amount with the relevant type (i.e. EXT2)
@@ -295,9 +518,9 @@ bool exactFallback(const TriEdgeIn &input)
     FixExt4_1<IN_BITS>                  ep[2];
     FixExt4_1<IN_BITS>                  tp[3];
     for(uint i=0; i<2; i++)
-        toFixExt(ep[i], input.edge.p[i]);
+        toFixExt(ep[i], input.edge.p[i], ctxt->quantizer);
     for(uint i=0; i<3; i++)
-        toFixExt(tp[i], input.tri.p[i]);
+        toFixExt(tp[i], input.tri.p[i], ctxt->quantizer);
     
     // construct geometry
     FixExt4_2<LINE_BITS>                e;
@@ -315,7 +538,13 @@ bool exactFallback(const TriEdgeIn &input)
     if(e3sign < 0) {
         neg(pisct, pisct);
     } else if(e3sign == 0) {
-        degeneracy_count++;
+        // The edge is parallel to the triangle's plane.  If it lies
+        // off the plane, the meet is a point at infinity and the
+        // intersection is plainly empty.  Only if it lies in the
+        // plane does the meet vanish, which is a true degeneracy.
+        if(sign(pisct.e0) == 0 && sign(pisct.e1) == 0 &&
+                                  sign(pisct.e2) == 0)
+            ctxt->degeneracy_count++;
         return true;
     }
     
@@ -353,59 +582,213 @@ bool exactFallback(const TriEdgeIn &input)
     if(sign_e0 == 0 || sign_e1 == 0 ||
        sign_t0 == 0 || sign_t1 == 0 || sign_t2 == 0)
     {
-        degeneracy_count++;
+        ctxt->degeneracy_count++;
     }
     return false;
 }
 
-bool emptyExact(const TriEdgeIn &input)
+// for queries the double filter couldn't decide
+bool uncertainFallback(const TriEdgeIn &input, ExactArithmeticContext *ctxt)
 {
-    callcount++;
+    ctxt->ddouble_count++;
+    int filter = emptyFilterDD(input);
+    if(filter != 0)
+        return filter > 0;
+    ctxt->exact_count++;
+    return exactFallback(input, ctxt);
+}
+
+bool emptyExact(const TriEdgeIn &input, ExactArithmeticContext *ctxt)
+{
+    ctxt->callcount++;
     int filter = emptyFilter(input);
+    if(filter == 0)
+        return uncertainFallback(input, ctxt);
+    else
+        return filter > 0;
+}
+
+bool emptyExact(const PreparedTri &tri, const PreparedEdge &edge,
+                ExactArithmeticContext *ctxt)
+{
+    ctxt->callcount++;
+    int filter = emptyFilter(tri, edge);
     if(filter == 0) {
-        exact_count++;
-        return exactFallback(input);
+        TriEdgeIn input;
+        input.tri   = tri.in;
+        input.edge  = edge.in;
+        return uncertainFallback(input, ctxt);
     }
     else
         return filter > 0;
 }
 
-Vec3d coordsExact(const TriEdgeIn &input)
+
+// A point snapped to the quantization grid, and the exact orientation
+// of three of them projected onto the coordinate plane (i, j)
+typedef BitInt<IN_BITS>::Rep GridPoint[3];
+
+void toGridPoint(GridPoint &out, const Vec3d &in,
+                 const Quantization::Quantizer &quantizer)
+{
+    for(uint k=0; k<3; k++)
+        out[k] = BitInt<IN_BITS>::Rep(quantizer.quantize2int(in[k]));
+}
+
+int orient2d(const GridPoint &a, const GridPoint &b, const GridPoint &c,
+             uint i, uint j)
+{
+    const static int DIFF_BITS      = IN_BITS + 1;
+    const static int PRODUCT_BITS   = 2*DIFF_BITS;
+    const static int DET_BITS       = PRODUCT_BITS + 1;
+    
+    BitInt<DIFF_BITS>::Rep      abi, abj, aci, acj;
+    sub(abi, b[i], a[i]);       sub(abj, b[j], a[j]);
+    sub(aci, c[i], a[i]);       sub(acj, c[j], a[j]);
+    BitInt<PRODUCT_BITS>::Rep   lhs, rhs;
+    mul(lhs, abi, acj);
+    mul(rhs, abj, aci);
+    BitInt<DET_BITS>::Rep       det;
+    sub(det, lhs, rhs);
+    return sign(det);
+}
+
+// is c, known to be collinear with a and b, on the segment ab?
+bool onSegment(const GridPoint &a, const GridPoint &b, const GridPoint &c)
+{
+    const static int DIFF_BITS = IN_BITS + 1;
+    for(uint k=0; k<3; k++) {
+        BitInt<DIFF_BITS>::Rep  ca, cb;
+        sub(ca, a[k], c[k]);
+        sub(cb, b[k], c[k]);
+        if(sign(ca) * sign(cb) > 0)
+            return false;
+    }
+    return true;
+}
+
+bool emptyCoplanarExact(const TriEdgeIn &input,
+                        const ExactArithmeticContext *ctxt)
+{
+    GridPoint   tp[3];
+    GridPoint   ep[2];
+    for(uint k=0; k<3; k++)
+        toGridPoint(tp[k], input.tri.p[k], ctxt->quantizer);
+    for(uint k=0; k<2; k++)
+        toGridPoint(ep[k], input.edge.p[k], ctxt->quantizer);
+    
+    // Project along an axis the triangle's plane isn't parallel to;
+    // that keeps every point of the plane apart.  A triangle with no
+    // such axis has collapsed, and can't be told apart from a contact
+    uint    i = 0, j = 0;
+    int     tri_sign = 0;
+    for(uint axis=0; axis<3 && tri_sign == 0; axis++) {
+        i = (axis+1)%3;
+        j = (axis+2)%3;
+        tri_sign = orient2d(tp[0], tp[1], tp[2], i, j);
+    }
+    if(tri_sign == 0)
+        return false;
+    
+    // an endpoint of the edge inside of or on the triangle
+    for(uint k=0; k<2; k++) {
+        bool inside = true;
+        for(uint l=0; l<3 && inside; l++)
+            inside = tri_sign * orient2d(tp[l], tp[(l+1)%3], ep[k], i, j)
+                     >= 0;
+        if(inside)
+            return false;
+    }
+    
+    // or else the edge crossing or touching a side of the triangle
+    for(uint l=0; l<3; l++) {
+        const GridPoint &a = tp[l];
+        const GridPoint &b = tp[(l+1)%3];
+        int o0 = orient2d(ep[0], ep[1], a, i, j);
+        int o1 = orient2d(ep[0], ep[1], b, i, j);
+        int o2 = orient2d(a, b, ep[0], i, j);
+        int o3 = orient2d(a, b, ep[1], i, j);
+        if(o0 * o1 < 0 && o2 * o3 < 0)
+            return false;
+        if((o0 == 0 && onSegment(ep[0], ep[1], a)) ||
+           (o1 == 0 && onSegment(ep[0], ep[1], b)) ||
+           (o2 == 0 && onSegment(a, b, ep[0])) ||
+           (o3 == 0 && onSegment(a, b, ep[1])))
+            return false;
+    }
+    return true;
+}
+
+void emptyExactBatch(uint n,
+                     const PreparedTri * const tris[],
+                     const PreparedEdge * const edges[],
+                     bool empty[],
+                     ExactArithmeticContext *ctxt)
+{
+#if !defined(DBL4_AVX) && !defined(DBL4_SSE2)
+    // without SIMD, the one pair at a time filter is faster
+    for(uint i=0; i<n; i++)
+        empty[i] = emptyExact(*(tris[i]), *(edges[i]), ctxt);
+    return;
+#endif
+    for(uint i=0; i<n; i += 4) {
+        // pad out the last group by repeating its final pair
+        const PreparedTri   *t4[4];
+        const PreparedEdge  *e4[4];
+        for(uint l=0; l<4; l++) {
+            uint k = std::min(i+l, n-1);
+            t4[l] = tris[k];
+            e4[l] = edges[k];
+        }
+        int filter[4];
+        emptyFilter4(t4, e4, filter);
+        
+        for(uint l=0; l<4 && i+l<n; l++) {
+            ctxt->callcount++;
+            if(filter[l] == 0) {
+                TriEdgeIn input;
+                input.tri   = t4[l]->in;
+                input.edge  = e4[l]->in;
+                empty[i+l] = uncertainFallback(input, ctxt);
+            }
+            else
+                empty[i+l] = filter[l] > 0;
+        }
+    }
+}
+
+Vec3d coordsExact(const TriEdgeIn &input, const ExactArithmeticContext *ctxt)
 {
     // How many bits do we need for various intermediary values?
     // Here we label the amount with the relevant type (i.e. EXT2)
     // and the relevant role
-    //const static int LINE_BITS       = 2*IN_BITS + 1;
-    //const static int TRI_BITS        = LINE_BITS + IN_BITS + 2;
-    //const static int ISCT_BITS       = TRI_BITS + LINE_BITS + 2;
-    //const static int LINE_A_BITS     = ISCT_BITS + IN_BITS + 1;
-    //const static int TRI_A_BITS      = LINE_A_BITS + IN_BITS + 2;
-    //const static int INNER_LINE_BITS = LINE_A_BITS + LINE_BITS + 3;
-    //const static int INNER_TRI_BITS  = TRI_A_BITS + TRI_BITS + 2;
+    const static int LINE_BITS       = 2*IN_BITS + 1;
+    const static int TRI_BITS        = LINE_BITS + IN_BITS + 2;
+    const static int ISCT_BITS       = TRI_BITS + LINE_BITS + 2;
     
     // pull in points
-    GmpExt4_1                           ep[2];
-    GmpExt4_1                           tp[3];
+    FixExt4_1<IN_BITS>                  ep[2];
+    FixExt4_1<IN_BITS>                  tp[3];
     for(uint i=0; i<2; i++)
-        toGmpExt(ep[i], input.edge.p[i]);
+        toFixExt(ep[i], input.edge.p[i], ctxt->quantizer);
     for(uint i=0; i<3; i++)
-        toGmpExt(tp[i], input.tri.p[i]);
+        toFixExt(tp[i], input.tri.p[i], ctxt->quantizer);
     
     // construct geometry
-    GmpExt4_2                           e;
+    FixExt4_2<LINE_BITS>                e;
     join(e, ep[0], ep[1]);
-    GmpExt4_2                           temp_up;
-    GmpExt4_3                           t;
+    FixExt4_2<LINE_BITS>                temp_up;
+    FixExt4_3<TRI_BITS>                 t;
     join(temp_up, tp[0], tp[1]);
     join(t,     temp_up, tp[2]);
     
     // compute the point of intersection
-    GmpExt4_1                           pisct;
+    FixExt4_1<ISCT_BITS>                pisct;
     meet(pisct, e, t);
     
     // convert to double
     Vec3d result;
-    toVec3d(result, pisct);
+    toVec3d(result, pisct, ctxt->quantizer);
     //std::cout << result << std::endl;
     return result;
 }
@@ -417,9 +800,9 @@ Vec3d coordsExact(const TriEdgeIn &input)
 
 
 
-bool isEmpty(const TriTriTriIn &input)
+bool isEmpty(const TriTriTriIn &input, ExactArithmeticContext *ctxt)
 {
-    callcount++;
+    ctxt->callcount++;
     
     Ext4_2 temp_e2;
     
@@ -549,7 +932,62 @@ int emptyFilter(const TriTriTriIn &input)
         return -1; // i.e. false (the intersection is not empty)
 }
 
-bool exactFallback(const TriTriTriIn &input)
+const static double COEFF_DD_IT222_PISCT= 2.0*(20.0*DDEPS + 256.0*DDEPS2);
+const static double COEFF_DD_IT222_S2   = 2.0*(34.0*DDEPS + 1024.0*DDEPS2);
+
+int emptyFilterDD(const TriTriTriIn &input)
+{
+    DDExt4_2 temp2;                         DKExt4_2 ktemp2;
+    DDExt4_1 p[3][3];                       DKExt4_1 kp[3][3];
+    DDExt4_3 t[3];                          DKExt4_3 kt[3];
+    
+    // load the points and form triangles
+    for(uint i=0; i<3; i++) {
+      for(uint j=0; j<3; j++) {
+        toDDExt(p[i][j], kp[i][j], input.tri[i].p[j]);
+      }
+      join(temp2, p[i][0], p[i][1]);        absJoin(ktemp2, kp[i][0], kp[i][1]);
+      join(t[i],  temp2,   p[i][2]);        absJoin(kt[i],  ktemp2,   kp[i][2]);
+    }
+    
+    // compute the point of intersection
+    DDExt4_1 pisct;                         DKExt4_1 kpisct;
+    meet(temp2, t[0],  t[1]);               absMeet(ktemp2, kt[0],  kt[1]);
+    meet(pisct, temp2, t[2]);               absMeet(kpisct, ktemp2, kt[2]);
+    if(!filterCheck(pisct.e3, kpisct.e3, COEFF_DD_IT222_PISCT))
+        return 0; // i.e. uncertain
+    // need to adjust for negative w-coordinate
+    if(pisct.e3.hi < 0.0)
+        neg(pisct, pisct);
+    
+    bool uncertain = false;
+    for(int i=0; i<3; i++) {
+      for(int j=0; j<3; j++) {
+        DDExt4_2 b;                         DKExt4_2 kb;
+        DDExt4_3 a;                         DKExt4_3 ka;
+        join(b, (j==0)? pisct : p[i][0],
+                (j==1)? pisct : p[i][1]);
+        join(a, b,
+                (j==2)? pisct : p[i][2]);
+                                    absJoin(kb, (j==0)? kpisct : kp[i][0],
+                                                (j==1)? kpisct : kp[i][1]);
+                                    absJoin(ka, kb,
+                                                (j==2)? kpisct : kp[i][2]);
+        DDouble dot = inner(t[i], a);       double kdot = inner(kt[i], ka);
+            bool outside = dot.hi < 0.0;
+            bool reliable = filterCheck(dot, kdot, COEFF_DD_IT222_S2);
+            if(reliable && outside)
+                return 1; // i.e. true
+            if(!reliable)   uncertain = true;
+      }
+    }
+    if(uncertain)
+        return 0;
+    else
+        return -1; // i.e. false (the intersection is not empty)
+}
+
+bool exactFallback(const TriTriTriIn &input, ExactArithmeticContext *ctxt)
 {
     // How many bits do we need for various intermediary values?
     // Here we label the amount with the relevant type (i.e. EXT2)
@@ -566,7 +1004,7 @@ bool exactFallback(const TriTriTriIn &input)
     FixExt4_3<EXT3_UP_BITS>             t[3];
     for(uint i=0; i<3; i++) {
         for(uint j=0; j<3; j++) {
-            toFixExt(p[i][j], input.tri[i].p[j]);
+            toFixExt(p[i][j], input.tri[i].p[j], ctxt->quantizer);
         }
         FixExt4_2<EXT2_UP_BITS>         temp;
         join(temp, p[i][0], p[i][1]);
@@ -585,7 +1023,11 @@ bool exactFallback(const TriTriTriIn &input)
     if(e3sign < 0) {
         neg(pisct, pisct);
     } else if(e3sign == 0) {
-        degeneracy_count++;
+        // as above, three planes meeting only at infinity
+        // (i.e. forming a prism) have no common point
+        if(sign(pisct.e0) == 0 && sign(pisct.e1) == 0 &&
+                                  sign(pisct.e2) == 0)
+            ctxt->degeneracy_count++;
         return true;
     }
     
@@ -610,58 +1052,59 @@ bool exactFallback(const TriTriTriIn &input)
         }
     }
     if(uncertain) {
-        degeneracy_count++;
+        ctxt->degeneracy_count++;
     }
     return false;
 }
 
-bool emptyExact(const TriTriTriIn &input)
+bool emptyExact(const TriTriTriIn &input, ExactArithmeticContext *ctxt)
 {
-    callcount++;
+    ctxt->callcount++;
     int filter = emptyFilter(input);
     if(filter == 0) {
-        exact_count++;
-        return exactFallback(input);
+        ctxt->ddouble_count++;
+        filter = emptyFilterDD(input);
+        if(filter != 0)
+            return filter > 0;
+        ctxt->exact_count++;
+        return exactFallback(input, ctxt);
     }
     else
         return filter > 0;
 }
 
-Vec3d coordsExact(const TriTriTriIn &input)
+Vec3d coordsExact(const TriTriTriIn &input, const ExactArithmeticContext *ctxt)
 {
     // How many bits do we need for various intermediary values?
     // Here we label the amount with the relevant type (i.e. EXT2)
     // and the relevant role
-    //const static int EXT2_UP_BITS = 2*IN_BITS + 1;
-    //const static int EXT3_UP_BITS = EXT2_UP_BITS + IN_BITS + 2;
-    //const static int EXT2_DN_BITS = 2*EXT3_UP_BITS + 1;
-    //const static int ISCT_BITS    = EXT2_DN_BITS + EXT3_UP_BITS + 2;
-    //const static int EXT2_TA_BITS = ISCT_BITS + IN_BITS + 1;
-    //const static int EXT3_TA_BITS = EXT2_TA_BITS + IN_BITS + 2;
-    //const static int INNER_BITS   = EXT3_TA_BITS + EXT3_UP_BITS + 2;
-    
-    GmpExt4_1                           p[3][3];
-    GmpExt4_3                           t[3];
+    const static int EXT2_UP_BITS = 2*IN_BITS + 1;
+    const static int EXT3_UP_BITS = EXT2_UP_BITS + IN_BITS + 2;
+    const static int EXT2_DN_BITS = 2*EXT3_UP_BITS + 1;
+    const static int ISCT_BITS    = EXT2_DN_BITS + EXT3_UP_BITS + 2;
+    
+    FixExt4_1<IN_BITS>                  p[3][3];
+    FixExt4_3<EXT3_UP_BITS>             t[3];
     for(uint i=0; i<3; i++) {
         for(uint j=0; j<3; j++) {
-            toGmpExt(p[i][j], input.tri[i].p[j]);
+            toFixExt(p[i][j], input.tri[i].p[j], ctxt->quantizer);
         }
-        GmpExt4_2                       temp;
+        FixExt4_2<EXT2_UP_BITS>         temp;
         join(temp, p[i][0], p[i][1]);
         join(t[i], temp,    p[i][2]);
     }
     
     // compute the point of intersection
-    GmpExt4_1                           pisct;
+    FixExt4_1<ISCT_BITS>                pisct;
     {
-        GmpExt4_2                       temp;
+        FixExt4_2<EXT2_DN_BITS>         temp;
         meet(temp,  t[0], t[1]);
         meet(pisct, temp, t[2]);
     }
     
     // convert to double
     Vec3d result;
-    toVec3d(result, pisct);
+    toVec3d(result, pisct, ctxt->quantizer);
     return result;
 }
 
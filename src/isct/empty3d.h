@@ -26,9 +26,42 @@
 #pragma once
 
 #include "vec.h"
+#include "quantization.h"
+#include "absext4.h"
 
 namespace Empty3d {
 
+// State used by the exact tests below: the quantization grid that
+// the input coordinates were snapped to, and counters recording
+// how the tests were resolved.
+// Contexts are not shared between threads.  Give each thread its own
+// copy and add the counters back together afterwards.
+struct ExactArithmeticContext
+{
+    Quantization::Quantizer quantizer;
+    
+    // Each query first goes through a double precision filter, then
+    // (if that is uncertain) a double-double filter, and only then
+    // the exact fixed-width integer computation
+    int degeneracy_count; // count degeneracies encountered
+    int ddouble_count; // count of double filter calls failed
+    int exact_count; // count of double-double filter calls failed
+    int callcount; // total call count
+    
+    ExactArithmeticContext() :
+        degeneracy_count(0), ddouble_count(0), exact_count(0), callcount(0)
+    {}
+    inline void resetCounters() {
+        degeneracy_count = ddouble_count = exact_count = callcount = 0;
+    }
+    inline void addCounters(const ExactArithmeticContext &other) {
+        degeneracy_count   += other.degeneracy_count;
+        ddouble_count      += other.ddouble_count;
+        exact_count        += other.exact_count;
+        callcount          += other.callcount;
+    }
+};
+
 struct TriIn
 {
     Vec3d p[3];
@@ -46,23 +79,59 @@ struct TriEdgeIn
     TriIn   tri;
     EdgeIn  edge;
 };
-bool isEmpty(const TriEdgeIn &input);
+bool isEmpty(const TriEdgeIn &input, ExactArithmeticContext *ctxt);
 Vec3d coords(const TriEdgeIn &input);
-bool emptyExact(const TriEdgeIn &input);
-Vec3d coordsExact(const TriEdgeIn &input);
+bool emptyExact(const TriEdgeIn &input, ExactArithmeticContext *ctxt);
+Vec3d coordsExact(const TriEdgeIn &input, const ExactArithmeticContext *ctxt);
+// The tests above only count an edge lying in the triangle's plane as
+// a degeneracy.  This one decides, exactly, whether such an edge and
+// the triangle have no point in common
+bool emptyCoplanarExact(const TriEdgeIn &input,
+                        const ExactArithmeticContext *ctxt);
+
+// A triangle or edge can be tested against many candidates.
+// The prepared forms cache its points, its plane/line and their
+// magnitude bounds for the floating point filter, so that each
+// test only has to do the per-pair work.
+struct PreparedTri
+{
+    TriIn                   in;
+    Ext4::Ext4_1            p[3];
+    AbsExt4::AbsExt4_1      kp[3];
+    Ext4::Ext4_3            plane;
+    AbsExt4::AbsExt4_3      kplane;
+};
+struct PreparedEdge
+{
+    EdgeIn                  in;
+    Ext4::Ext4_1            p[2];
+    AbsExt4::AbsExt4_1      kp[2];
+    Ext4::Ext4_2            line;
+    AbsExt4::AbsExt4_2      kline;
+};
+void prepare(PreparedTri &prep, const TriIn &input);
+void prepare(PreparedEdge &prep, const EdgeIn &input);
+// same result as emptyExact() on the unprepared input
+bool emptyExact(const PreparedTri &tri, const PreparedEdge &edge,
+                ExactArithmeticContext *ctxt);
+// emptyExact() on n pairs (tris[i], edges[i]), writing the results
+// to empty[i].  The floating point filter is evaluated on 4 pairs at
+// a time using SIMD; only the pairs it can't decide are re-examined
+// with exact arithmetic.
+void emptyExactBatch(uint n,
+                     const PreparedTri * const tris[],
+                     const PreparedEdge * const edges[],
+                     bool empty[],
+                     ExactArithmeticContext *ctxt);
 
 struct TriTriTriIn
 {
     TriIn tri[3];
 };
-bool isEmpty(const TriTriTriIn &input);
+bool isEmpty(const TriTriTriIn &input, ExactArithmeticContext *ctxt);
 Vec3d coords(const TriTriTriIn &input);
-bool emptyExact(const TriTriTriIn &input);
-Vec3d coordsExact(const TriTriTriIn &input);
-
-extern int degeneracy_count; // count degeneracies encountered
-extern int exact_count; // count of filter calls failed
-extern int callcount; // total call count
+bool emptyExact(const TriTriTriIn &input, ExactArithmeticContext *ctxt);
+Vec3d coordsExact(const TriTriTriIn &input, const ExactArithmeticContext *ctxt);
 
 /*
 // exact versions
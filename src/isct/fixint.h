@@ -45,12 +45,16 @@
 
 
 
-#ifdef _WIN32
+#if defined(CORK_NO_GMP)
+#include "mpnport.h"
+#elif defined(_WIN32)
 #include <mpir.h>
 #else
 #include <gmp.h>
 #endif
 
+#include <cfloat>
+#include <cmath>
 #include <iostream>
 #include <iomanip>
 #include <string>
@@ -302,30 +306,43 @@ int sign(const LimbInt<N> &in)
     return SIGN_INT(in.limbs,N) * int(nonzero);
 }
 
-//template<int N>
-//inline
-//double approximate(const LimbInt<N> &in)
-//{
-//    std::cout << in << std::endl;
-//    // not the most efficient implementation, but it should work
-//    LimbInt<N>  tmp;
-//    double      sign;
-//    if(SIGN_BOOL(in.limbs, N-1)) {
-//        neg(tmp, in);
-//        sign = -1.0;
-//    } else {
-//        tmp = in;
-//        sign = 1.0;
-//    }
-//    std::cout << tmp << std::endl;
-//    std::cout << typeid(mp_limb_t).name() << std::endl;
-//    std::cout << double(in.limbs[2]) << std::endl;
-//    double result = 0.0;
-//    for(int i=0; i<N; i++) {
-//        result += ldexp(double(in.limbs[i]), i * LIMB_BIT_SIZE);
-//    }
-//    return sign * result;
-//}
+// Convert to a double, rounding towards zero like mpz_get_d()
+template<int N>
+inline
+double toDouble(const LimbInt<N> &in)
+{
+    LimbInt<N>  mag;
+    double      sgn = 1.0;
+    if(SIGN_BOOL(in.limbs, N)) {
+        mpn_neg(mag.limbs, in.limbs, N);
+        sgn = -1.0;
+    } else {
+        mag = in;
+    }
+    
+    int top = N-1;
+    while(top >= 0 && mag.limbs[top] == 0)
+        top--;
+    if(top < 0)
+        return 0.0;
+    
+    // gather the leading bits, dropping the rest; the
+    // conversion of the truncated mantissa to double is exact
+    mp_limb_t   toplimb = mag.limbs[top];
+    int         length  = top * LIMB_BIT_SIZE;
+    while(toplimb) {
+        toplimb >>= 1;
+        length++;
+    }
+    unsigned long long mantissa = 0;
+    for(int b = length-1; b >= length - DBL_MANT_DIG; b--) {
+        mantissa <<= 1;
+        if(b >= 0)
+            mantissa |= (mag.limbs[b / LIMB_BIT_SIZE] >>
+                         (b % LIMB_BIT_SIZE)) & 1;
+    }
+    return sgn * std::ldexp(double(mantissa), length - DBL_MANT_DIG);
+}
 
 template<int N>
 inline
@@ -0,0 +1,234 @@
+// +-------------------------------------------------------------------------
+// | genext4.h
+// | 
+// | Author: Gilbert Bernstein
+// +-------------------------------------------------------------------------
+// | COPYRIGHT:
+// |    Copyright Gilbert Bernstein 2013
+// |    See the included COPYRIGHT file for further details.
+// |    
+// |    This file is part of the Cork library.
+// |
+// |    Cork is free software: you can redistribute it and/or modify
+// |    it under the terms of the GNU Lesser General Public License as
+// |    published by the Free Software Foundation, either version 3 of
+// |    the License, or (at your option) any later version.
+// |
+// |    Cork is distributed in the hope that it will be useful,
+// |    but WITHOUT ANY WARRANTY; without even the implied warranty of
+// |    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// |    GNU Lesser General Public License for more details.
+// |
+// |    You should have received a copy 
+// |    of the GNU Lesser General Public License
+// |    along with Cork.  If not, see <http://www.gnu.org/licenses/>.
+// +-------------------------------------------------------------------------
+#pragma once
+
+/*
+ *
+ *  GenExt4
+ *
+ *      The Ext4 and AbsExt4 operations used by the emptiness filters,
+ *      written generically over the scalar type.
+ *
+ *      Instantiated with Dbl4, this evaluates a filter on 4 inputs at
+ *      once.  Every operation performs the same floating point
+ *      operations in the same order as its Ext4 (or AbsExt4)
+ *      counterpart, so the results agree bit for bit.
+ *      Instantiated with DDouble, it evaluates the filters in
+ *      double-double precision.
+ *
+ */
+
+namespace GenExt4 {
+
+// types for k-vectors in R4:
+//      GenExt4_k<S>
+
+template<class S>
+struct GenExt4_1 {
+    S e0, e1, e2, e3;
+};
+
+template<class S>
+struct GenExt4_2 {
+    S e01, e02, e03, e12, e13, e23;
+};
+
+template<class S>
+struct GenExt4_3 {
+    S e012, e013, e023, e123;
+};
+
+
+// ************************
+// A neg takes a k-vector and returns its negation
+// neg(X,Y) is safe for X=Y
+template<class S> inline
+void neg(GenExt4_1<S> &out, const GenExt4_1<S> &in) {
+    out.e0 = -in.e0;    out.e1 = -in.e1;
+    out.e2 = -in.e2;    out.e3 = -in.e3;
+}
+
+
+// ************************
+// A dual operation takes a k-vector and returns a (4-k)-vector
+// A reverse dual operation inverts the dual operation
+// dual(X,Y) is not safe for X=Y (same with revdual)
+template<class S> inline
+void dual(GenExt4_1<S> &out, const GenExt4_3<S> &in) {
+    out.e0 =  in.e123;
+    out.e1 = -in.e023;
+    out.e2 =  in.e013;
+    out.e3 = -in.e012;
+}
+template<class S> inline
+void dual(GenExt4_2<S> &out, const GenExt4_2<S> &in) {
+    out.e01 =  in.e23;
+    out.e02 = -in.e13;
+    out.e03 =  in.e12;
+    out.e12 =  in.e03;
+    out.e13 = -in.e02;
+    out.e23 =  in.e01;
+}
+template<class S> inline
+void revdual(GenExt4_2<S> &out, const GenExt4_2<S> &in) {
+    dual(out, in);
+}
+template<class S> inline
+void revdual(GenExt4_1<S> &out, const GenExt4_3<S> &in) {
+    out.e0 = -in.e123;
+    out.e1 =  in.e023;
+    out.e2 = -in.e013;
+    out.e3 =  in.e012;
+}
+
+
+// ************************
+// A join takes a j-vector and a k-vector and returns a (j+k)-vector
+template<class S> inline
+void join(GenExt4_2<S> &out, const GenExt4_1<S> &lhs,
+                             const GenExt4_1<S> &rhs) {
+    out.e01 = (lhs.e0 * rhs.e1) - (rhs.e0 * lhs.e1);
+    out.e02 = (lhs.e0 * rhs.e2) - (rhs.e0 * lhs.e2);
+    out.e03 = (lhs.e0 * rhs.e3) - (rhs.e0 * lhs.e3);
+    out.e12 = (lhs.e1 * rhs.e2) - (rhs.e1 * lhs.e2);
+    out.e13 = (lhs.e1 * rhs.e3) - (rhs.e1 * lhs.e3);
+    out.e23 = (lhs.e2 * rhs.e3) - (rhs.e2 * lhs.e3);
+}
+template<class S> inline
+void join(GenExt4_3<S> &out, const GenExt4_2<S> &lhs,
+                             const GenExt4_1<S> &rhs) {
+    out.e012 = (lhs.e01 * rhs.e2) - (lhs.e02 * rhs.e1) + (lhs.e12 *rhs.e0);
+    out.e013 = (lhs.e01 * rhs.e3) - (lhs.e03 * rhs.e1) + (lhs.e13 *rhs.e0);
+    out.e023 = (lhs.e02 * rhs.e3) - (lhs.e03 * rhs.e2) + (lhs.e23 *rhs.e0);
+    out.e123 = (lhs.e12 * rhs.e3) - (lhs.e13 * rhs.e2) + (lhs.e23 *rhs.e1);
+}
+
+
+// ************************
+// A meet takes a j-vector and a k-vector and returns a (j+k-4)-vector
+template<class S> inline
+void meet(GenExt4_2<S> &out, const GenExt4_3<S> &lhs,
+                             const GenExt4_3<S> &rhs) {
+    GenExt4_2<S> out_dual;
+    GenExt4_1<S> lhs_dual;
+    GenExt4_1<S> rhs_dual;
+    dual(lhs_dual, lhs);
+    dual(rhs_dual, rhs);
+    join(out_dual, lhs_dual, rhs_dual);
+    revdual(out, out_dual);
+}
+template<class S> inline
+void meet(GenExt4_1<S> &out, const GenExt4_2<S> &lhs,
+                             const GenExt4_3<S> &rhs) {
+    GenExt4_3<S> out_dual;
+    GenExt4_2<S> lhs_dual;
+    GenExt4_1<S> rhs_dual;
+    dual(lhs_dual, lhs);
+    dual(rhs_dual, rhs);
+    join(out_dual, lhs_dual, rhs_dual);
+    revdual(out, out_dual);
+}
+
+
+// ************************
+// An inner product takes two k-vectors and produces a single number
+template<class S> inline
+S inner(const GenExt4_2<S> &lhs, const GenExt4_2<S> &rhs) {
+    S acc = S(0.0);
+    acc = acc + lhs.e01 * rhs.e01;
+    acc = acc + lhs.e02 * rhs.e02;
+    acc = acc + lhs.e03 * rhs.e03;
+    acc = acc + lhs.e12 * rhs.e12;
+    acc = acc + lhs.e13 * rhs.e13;
+    acc = acc + lhs.e23 * rhs.e23;
+    return acc;
+}
+template<class S> inline
+S inner(const GenExt4_3<S> &lhs, const GenExt4_3<S> &rhs) {
+    S acc = S(0.0);
+    acc = acc + lhs.e012 * rhs.e012;
+    acc = acc + lhs.e013 * rhs.e013;
+    acc = acc + lhs.e023 * rhs.e023;
+    acc = acc + lhs.e123 * rhs.e123;
+    return acc;
+}
+
+
+// ************************
+// The AbsExt4 versions bound the magnitudes of the results above,
+// given bounds on the magnitudes of the inputs.  The signs all
+// drop out, so the duals are plain permutations and the joins add.
+template<class S> inline
+void absJoin(GenExt4_2<S> &out, const GenExt4_1<S> &lhs,
+                                const GenExt4_1<S> &rhs) {
+    out.e01 = (lhs.e0 * rhs.e1) + (rhs.e0 * lhs.e1);
+    out.e02 = (lhs.e0 * rhs.e2) + (rhs.e0 * lhs.e2);
+    out.e03 = (lhs.e0 * rhs.e3) + (rhs.e0 * lhs.e3);
+    out.e12 = (lhs.e1 * rhs.e2) + (rhs.e1 * lhs.e2);
+    out.e13 = (lhs.e1 * rhs.e3) + (rhs.e1 * lhs.e3);
+    out.e23 = (lhs.e2 * rhs.e3) + (rhs.e2 * lhs.e3);
+}
+template<class S> inline
+void absJoin(GenExt4_3<S> &out, const GenExt4_2<S> &lhs,
+                                const GenExt4_1<S> &rhs) {
+    out.e012 = (lhs.e01 * rhs.e2) + (lhs.e02 * rhs.e1) + (lhs.e12 *rhs.e0);
+    out.e013 = (lhs.e01 * rhs.e3) + (lhs.e03 * rhs.e1) + (lhs.e13 *rhs.e0);
+    out.e023 = (lhs.e02 * rhs.e3) + (lhs.e03 * rhs.e2) + (lhs.e23 *rhs.e0);
+    out.e123 = (lhs.e12 * rhs.e3) + (lhs.e13 * rhs.e2) + (lhs.e23 *rhs.e1);
+}
+template<class S> inline
+void absMeet(GenExt4_2<S> &out, const GenExt4_3<S> &lhs,
+                                const GenExt4_3<S> &rhs) {
+    GenExt4_2<S> out_dual;
+    GenExt4_1<S> lhs_dual;
+    GenExt4_1<S> rhs_dual;
+    lhs_dual.e0  = lhs.e123;    lhs_dual.e1  = lhs.e023;
+    lhs_dual.e2  = lhs.e013;    lhs_dual.e3  = lhs.e012;
+    rhs_dual.e0  = rhs.e123;    rhs_dual.e1  = rhs.e023;
+    rhs_dual.e2  = rhs.e013;    rhs_dual.e3  = rhs.e012;
+    absJoin(out_dual, lhs_dual, rhs_dual);
+    out.e01 = out_dual.e23;     out.e02 = out_dual.e13;
+    out.e03 = out_dual.e12;     out.e12 = out_dual.e03;
+    out.e13 = out_dual.e02;     out.e23 = out_dual.e01;
+}
+template<class S> inline
+void absMeet(GenExt4_1<S> &out, const GenExt4_2<S> &lhs,
+                                const GenExt4_3<S> &rhs) {
+    GenExt4_3<S> out_dual;
+    GenExt4_2<S> lhs_dual;
+    GenExt4_1<S> rhs_dual;
+    lhs_dual.e01 = lhs.e23;     lhs_dual.e02 = lhs.e13;
+    lhs_dual.e03 = lhs.e12;     lhs_dual.e12 = lhs.e03;
+    lhs_dual.e13 = lhs.e02;     lhs_dual.e23 = lhs.e01;
+    rhs_dual.e0  = rhs.e123;    rhs_dual.e1  = rhs.e023;
+    rhs_dual.e2  = rhs.e013;    rhs_dual.e3  = rhs.e012;
+    absJoin(out_dual, lhs_dual, rhs_dual);
+    out.e0 = out_dual.e123;     out.e1 = out_dual.e023;
+    out.e2 = out_dual.e013;     out.e3 = out_dual.e012;
+}
+
+
+} // end namespace GenExt4
@@ -0,0 +1,192 @@
+// +-------------------------------------------------------------------------
+// | mpnport.h
+// | 
+// | Author: Gilbert Bernstein
+// +-------------------------------------------------------------------------
+// | COPYRIGHT:
+// |    Copyright Gilbert Bernstein 2013
+// |    See the included COPYRIGHT file for further details.
+// |    
+// |    This file is part of the Cork library.
+// |
+// |    Cork is free software: you can redistribute it and/or modify
+// |    it under the terms of the GNU Lesser General Public License as
+// |    published by the Free Software Foundation, either version 3 of
+// |    the License, or (at your option) any later version.
+// |
+// |    Cork is distributed in the hope that it will be useful,
+// |    but WITHOUT ANY WARRANTY; without even the implied warranty of
+// |    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// |    GNU Lesser General Public License for more details.
+// |
+// |    You should have received a copy 
+// |    of the GNU Lesser General Public License
+// |    along with Cork.  If not, see <http://www.gnu.org/licenses/>.
+// +-------------------------------------------------------------------------
+#pragma once
+
+/*
+ *
+ *  mpnport.h
+ *
+ *      Portable stand-ins for the handful of GMP low-level (mpn)
+ *      routines that fixint.h uses.  Only included when building
+ *      with CORK_NO_GMP defined, so that the fixed-width exact
+ *      arithmetic has no external dependency.
+ *
+ *      These follow the GMP calling conventions closely enough
+ *      for fixint.h, but are not a general replacement.  Where
+ *      the compiler has a 128-bit integer type we use 64-bit limbs,
+ *      otherwise 32-bit limbs with 64-bit intermediates.
+ *
+ */
+
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__SIZEOF_INT128__)
+typedef uint64_t            mp_limb_t;
+typedef unsigned __int128   mp_dlimb_t;
+#define GMP_NUMB_BITS       64
+#else
+typedef uint32_t            mp_limb_t;
+typedef uint64_t            mp_dlimb_t;
+#define GMP_NUMB_BITS       32
+#endif
+typedef long                mp_size_t;
+
+inline void mpn_copyi(mp_limb_t *rp, const mp_limb_t *sp, mp_size_t n)
+{
+    for(mp_size_t i=0; i<n; i++)
+        rp[i] = sp[i];
+}
+
+// rp = sp + b, returning the carry out
+inline mp_limb_t mpn_add_1(mp_limb_t *rp, const mp_limb_t *sp,
+                           mp_size_t n, mp_limb_t b)
+{
+    for(mp_size_t i=0; i<n; i++) {
+        mp_limb_t s = sp[i] + b;
+        b = (s < b)? 1 : 0;
+        rp[i] = s;
+    }
+    return b;
+}
+
+// rp = sp - b, returning the borrow out
+inline mp_limb_t mpn_sub_1(mp_limb_t *rp, const mp_limb_t *sp,
+                           mp_size_t n, mp_limb_t b)
+{
+    for(mp_size_t i=0; i<n; i++) {
+        mp_limb_t a = sp[i];
+        rp[i] = a - b;
+        b = (a < b)? 1 : 0;
+    }
+    return b;
+}
+
+inline mp_limb_t mpn_add_n(mp_limb_t *rp, const mp_limb_t *up,
+                           const mp_limb_t *vp, mp_size_t n)
+{
+    mp_limb_t carry = 0;
+    for(mp_size_t i=0; i<n; i++) {
+        mp_limb_t u = up[i];
+        mp_limb_t s = u + vp[i];
+        mp_limb_t c = (s < u)? 1 : 0;
+        rp[i] = s + carry;
+        carry = c | ((rp[i] < s)? 1 : 0);
+    }
+    return carry;
+}
+
+// requires un >= vn
+inline mp_limb_t mpn_add(mp_limb_t *rp,
+                         const mp_limb_t *up, mp_size_t un,
+                         const mp_limb_t *vp, mp_size_t vn)
+{
+    mp_limb_t carry = mpn_add_n(rp, up, vp, vn);
+    return mpn_add_1(rp + vn, up + vn, un - vn, carry);
+}
+
+// rp = -sp (two's complement), returning 1 unless sp was zero
+inline mp_limb_t mpn_neg(mp_limb_t *rp, const mp_limb_t *sp, mp_size_t n)
+{
+    mp_limb_t nonzero = 0;
+    for(mp_size_t i=0; i<n; i++) {
+        nonzero |= sp[i];
+        rp[i] = ~sp[i];
+    }
+    mpn_add_1(rp, rp, n, 1);
+    return (nonzero)? 1 : 0;
+}
+
+// rp[0..n) -= up[0..n) * v, returning the limb borrowed out of the top
+inline mp_limb_t mpn_submul_1(mp_limb_t *rp, const mp_limb_t *up,
+                              mp_size_t n, mp_limb_t v)
+{
+    mp_limb_t borrow = 0;
+    for(mp_size_t i=0; i<n; i++) {
+        mp_dlimb_t prod = mp_dlimb_t(up[i]) * v + borrow;
+        mp_limb_t lo = mp_limb_t(prod);
+        borrow = mp_limb_t(prod >> GMP_NUMB_BITS);
+        mp_limb_t r = rp[i];
+        rp[i] = r - lo;
+        borrow += (r < lo)? 1 : 0;
+    }
+    return borrow;
+}
+
+// rp[0..un+vn) = up * vp (unsigned); requires un >= vn
+inline mp_limb_t mpn_mul(mp_limb_t *rp,
+                         const mp_limb_t *up, mp_size_t un,
+                         const mp_limb_t *vp, mp_size_t vn)
+{
+    for(mp_size_t i=0; i<un+vn; i++)
+        rp[i] = 0;
+    for(mp_size_t j=0; j<vn; j++) {
+        mp_limb_t carry = 0;
+        for(mp_size_t i=0; i<un; i++) {
+            mp_dlimb_t t = mp_dlimb_t(up[i]) * vp[j] + rp[i+j] + carry;
+            rp[i+j] = mp_limb_t(t);
+            carry   = mp_limb_t(t >> GMP_NUMB_BITS);
+        }
+        rp[un+j] = carry;
+    }
+    return rp[un+vn-1];
+}
+
+inline void mpn_mul_n(mp_limb_t *rp,
+                      const mp_limb_t *up, const mp_limb_t *vp, mp_size_t n)
+{
+    mpn_mul(rp, up, n, vp, n);
+}
+
+// Write the base 10 digits (as values 0-9, most significant first)
+// of the unsigned number sp into str, returning the digit count.
+// Clobbers sp, like its GMP counterpart
+inline size_t mpn_get_str(unsigned char *str, int /*base = 10*/,
+                          mp_limb_t *sp, mp_size_t n)
+{
+    size_t count = 0;
+    while(n > 0 && sp[n-1] == 0)
+        n--;
+    do {
+        // divide by 10 in place, collecting the remainder
+        mp_dlimb_t rem = 0;
+        for(mp_size_t i=n-1; i>=0; i--) {
+            mp_dlimb_t cur = (rem << GMP_NUMB_BITS) | sp[i];
+            sp[i] = mp_limb_t(cur / 10);
+            rem   = cur % 10;
+        }
+        str[count++] = (unsigned char)(rem);
+        while(n > 0 && sp[n-1] == 0)
+            n--;
+    } while(n > 0);
+    // reverse into most significant first order
+    for(size_t i=0; i<count/2; i++) {
+        unsigned char tmp = str[i];
+        str[i] = str[count-1-i];
+        str[count-1-i] = tmp;
+    }
+    return count;
+}
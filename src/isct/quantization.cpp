@@ -1,34 +0,0 @@
-// +-------------------------------------------------------------------------
-// | quantization.h
-// | 
-// | Author: Gilbert Bernstein
-// +-------------------------------------------------------------------------
-// | COPYRIGHT:
-// |    Copyright Gilbert Bernstein 2013
-// |    See the included COPYRIGHT file for further details.
-// |    
-// |    This file is part of the Cork library.
-// |
-// |    Cork is free software: you can redistribute it and/or modify
-// |    it under the terms of the GNU Lesser General Public License as
-// |    published by the Free Software Foundation, either version 3 of
-// |    the License, or (at your option) any later version.
-// |
-// |    Cork is distributed in the hope that it will be useful,
-// |    but WITHOUT ANY WARRANTY; without even the implied warranty of
-// |    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-// |    GNU Lesser General Public License for more details.
-// |
-// |    You should have received a copy 
-// |    of the GNU Lesser General Public License
-// |    along with Cork.  If not, see <http://www.gnu.org/licenses/>.
-// +-------------------------------------------------------------------------
-#include "quantization.h"
-
-namespace Quantization {
-
-double MAGNIFY = 1.0;
-double RESHRINK = 1.0;
-
-} // end namespace Quantization
-
@@ -31,35 +31,46 @@ namespace Quantization {
 
 // NOTE: none of these values should be modified by the clients
 static const int BITS = 30;
-// MAGNIFY * RESHRINK == 1
-extern double MAGNIFY;
-extern double RESHRINK;
-inline int quantize2int(double number) {
-    return int(number * MAGNIFY);
-}
-inline double quantizedInt2double(int number) {
-    return RESHRINK * double(number);
-}
-inline double quantize(double number) {
-    return RESHRINK * double(int(number * MAGNIFY));
-}
 
-// given the specified number of bits,
-// and bound on the coordinate values of points,
-// fit as fine-grained a grid as possible over the space.
-inline void callibrate(double maximumMagnitude)
+// A quantization grid.  Every operation callibrates its own Quantizer,
+// so that operations on different meshes may run concurrently.
+class Quantizer
 {
-    int max_exponent;
-    std::frexp(maximumMagnitude, &max_exponent);
-    max_exponent++; // ensure that 2^max_exponent > maximumMagnitude
+public:
+    Quantizer() : MAGNIFY(1.0), RESHRINK(1.0) {}
     
-    // set constants
-    MAGNIFY = std::pow(2.0, BITS - max_exponent);
-    // we are guaranteed that maximumMagnitude * MAGNIFY < 2.0^BITS
-    RESHRINK = std::pow(2.0, max_exponent - BITS);
-}
+    inline int quantize2int(double number) const {
+        return int(number * MAGNIFY);
+    }
+    inline double quantizedInt2double(int number) const {
+        return RESHRINK * double(number);
+    }
+    inline double quantize(double number) const {
+        return RESHRINK * double(int(number * MAGNIFY));
+    }
+    inline double reshrink() const { return RESHRINK; }
+    
+    // given the specified number of bits,
+    // and bound on the coordinate values of points,
+    // fit as fine-grained a grid as possible over the space.
+    inline void callibrate(double maximumMagnitude)
+    {
+        int max_exponent;
+        std::frexp(maximumMagnitude, &max_exponent);
+        max_exponent++; // ensure that 2^max_exponent > maximumMagnitude
+        
+        // set constants
+        MAGNIFY = std::pow(2.0, BITS - max_exponent);
+        // we are guaranteed that maximumMagnitude * MAGNIFY < 2.0^BITS
+        RESHRINK = std::pow(2.0, max_exponent - BITS);
+    }
+    
+private:
+    // MAGNIFY * RESHRINK == 1
+    double MAGNIFY;
+    double RESHRINK;
+};
 
 
 } // end namespace Quantization
 
-
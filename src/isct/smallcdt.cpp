@@ -0,0 +1,383 @@
+// +-------------------------------------------------------------------------
+// | smallcdt.cpp
+// | 
+// | Author: Gilbert Bernstein
+// +-------------------------------------------------------------------------
+// | COPYRIGHT:
+// |    Copyright Gilbert Bernstein 2013
+// |    See the included COPYRIGHT file for further details.
+// |    
+// |    This file is part of the Cork library.
+// |
+// |    Cork is free software: you can redistribute it and/or modify
+// |    it under the terms of the GNU Lesser General Public License as
+// |    published by the Free Software Foundation, either version 3 of
+// |    the License, or (at your option) any later version.
+// |
+// |    Cork is distributed in the hope that it will be useful,
+// |    but WITHOUT ANY WARRANTY; without even the implied warranty of
+// |    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// |    GNU Lesser General Public License for more details.
+// |
+// |    You should have received a copy 
+// |    of the GNU Lesser General Public License
+// |    along with Cork.  If not, see <http://www.gnu.org/licenses/>.
+// +-------------------------------------------------------------------------
+#include "smallcdt.h"
+
+#include <cfloat>
+#include <cmath>
+
+namespace SmallCDT {
+
+namespace {
+
+// error bounds for the floating point orientation and incircle
+// tests, following Shewchuk's robust predicates
+const double EPS            = DBL_EPSILON * 0.5;
+const double CCW_ERRBOUND   = (3.0 + 16.0 * EPS) * EPS;
+const double ICC_ERRBOUND   = (10.0 + 96.0 * EPS) * EPS;
+
+const int MAX_DEGREE        = MAX_POINTS - 1;
+const int MAX_FACES         = MAX_SEGMENTS;
+const int MAX_FLIPS         = 4 * MAX_TRIANGLES * MAX_TRIANGLES;
+
+struct Graph
+{
+    int     degree[MAX_POINTS];
+    int     nbrs[MAX_POINTS][MAX_DEGREE];   // sorted counter-clockwise
+    bool    visited[MAX_POINTS][MAX_DEGREE];
+    bool    isSeg[MAX_POINTS][MAX_POINTS];
+};
+
+// State of a triangulation in progress.
+// Any test whose outcome can't be certified clears ok
+struct Problem
+{
+    const Input     &in;
+    Output          *out;
+    Graph           graph;
+    bool            ok;
+    
+    Problem(const Input &input, Output *output) :
+        in(input), out(output), ok(true)
+    {}
+    
+    // sign of the orientation of (a,b,c): +1 for counter-clockwise
+    int orient(int a, int b, int c)
+    {
+        if(in.lines[a] & in.lines[b] & in.lines[c])
+            return 0;
+        const double *pa = in.coords[a];
+        const double *pb = in.coords[b];
+        const double *pc = in.coords[c];
+        double detleft  = (pa[0] - pc[0]) * (pb[1] - pc[1]);
+        double detright = (pa[1] - pc[1]) * (pb[0] - pc[0]);
+        double det      = detleft - detright;
+        double errbound = CCW_ERRBOUND * (fabs(detleft) + fabs(detright));
+        if(det > errbound)      return 1;
+        if(-det > errbound)     return -1;
+        ok = false;
+        return 0;
+    }
+    
+    // is d certainly inside the circle through the
+    // counter-clockwise triangle (a,b,c)?
+    bool inCircle(int a, int b, int c, int d)
+    {
+        const double *pa = in.coords[a];
+        const double *pb = in.coords[b];
+        const double *pc = in.coords[c];
+        const double *pd = in.coords[d];
+        double adx = pa[0] - pd[0], ady = pa[1] - pd[1];
+        double bdx = pb[0] - pd[0], bdy = pb[1] - pd[1];
+        double cdx = pc[0] - pd[0], cdy = pc[1] - pd[1];
+        
+        double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+        double cdxady = cdx * ady, adxcdy = adx * cdy;
+        double adxbdy = adx * bdy, bdxady = bdx * ady;
+        double alift  = adx * adx + ady * ady;
+        double blift  = bdx * bdx + bdy * bdy;
+        double clift  = cdx * cdx + cdy * cdy;
+        
+        double det  = alift * (bdxcdy - cdxbdy)
+                    + blift * (cdxady - adxcdy)
+                    + clift * (adxbdy - bdxady);
+        double permanent = (fabs(bdxcdy) + fabs(cdxbdy)) * alift
+                         + (fabs(cdxady) + fabs(adxcdy)) * blift
+                         + (fabs(adxbdy) + fabs(bdxady)) * clift;
+        return det > ICC_ERRBOUND * permanent;
+    }
+    
+    // does neighbor a of v come before neighbor b,
+    // counter-clockwise from the positive x direction?
+    bool angleLess(int v, int a, int b)
+    {
+        const double *pv = in.coords[v];
+        // exact: the sign of a rounded difference is the exact sign
+        double ax = in.coords[a][0] - pv[0], ay = in.coords[a][1] - pv[1];
+        double bx = in.coords[b][0] - pv[0], by = in.coords[b][1] - pv[1];
+        bool alow = (ay < 0.0) || (ay == 0.0 && ax < 0.0);
+        bool blow = (by < 0.0) || (by == 0.0 && bx < 0.0);
+        if(alow != blow)
+            return blow;
+        int o = orient(v, a, b);
+        if(o == 0) // overlapping segments, or uncertain
+            ok = false;
+        return o > 0;
+    }
+    
+    bool buildGraph();
+    int  traceFace(int v, int k, int *face);
+    bool clipEars(int *poly, int n);
+    void delaunayFlips();
+    bool run();
+};
+
+bool Problem::buildGraph()
+{
+    for(int i=0; i<in.numPoints; i++) {
+        graph.degree[i] = 0;
+        for(int j=0; j<in.numPoints; j++)
+            graph.isSeg[i][j] = false;
+    }
+    for(int s=0; s<in.numSegments; s++) {
+        int a = in.segments[s][0];
+        int b = in.segments[s][1];
+        if(a == b || graph.isSeg[a][b])
+            return false;
+        graph.isSeg[a][b] = graph.isSeg[b][a] = true;
+        graph.nbrs[a][graph.degree[a]++] = b;
+        graph.nbrs[b][graph.degree[b]++] = a;
+    }
+    
+    for(int v=0; v<in.numPoints; v++) {
+        // every point must lie on a cycle; this also rules out
+        // isolated points and most dangling segments
+        int deg = graph.degree[v];
+        if(deg < 2)
+            return false;
+        // insertion sort the neighbors by angle
+        int *nbrs = graph.nbrs[v];
+        for(int i=1; i<deg; i++) {
+            int cur = nbrs[i];
+            int j = i;
+            while(j > 0 && angleLess(v, cur, nbrs[j-1])) {
+                nbrs[j] = nbrs[j-1];
+                j--;
+            }
+            nbrs[j] = cur;
+            if(!ok)     return false;
+        }
+        for(int i=0; i<deg; i++)
+            graph.visited[v][i] = false;
+    }
+    return true;
+}
+
+// Walk the face to the left of the half-edge from v to its k-th
+// neighbor, writing its vertices into face.  Returns the number of
+// vertices, or -1 if the face is not a simple polygon
+int Problem::traceFace(int v, int k, int *face)
+{
+    bool seen[MAX_POINTS];
+    for(int i=0; i<in.numPoints; i++)
+        seen[i] = false;
+    
+    int n = 0;
+    bool simple = true;
+    int u = v;
+    int ku = k;
+    while(!graph.visited[u][ku]) {
+        graph.visited[u][ku] = true;
+        if(seen[u] || n >= MAX_POINTS)
+            simple = false;
+        else
+            face[n++] = u;
+        seen[u] = true;
+        
+        // turn as far right as possible at the far end
+        int w = graph.nbrs[u][ku];
+        int deg = graph.degree[w];
+        int back = 0;
+        while(graph.nbrs[w][back] != u)
+            back++;
+        u  = w;
+        ku = (back + deg - 1) % deg;
+    }
+    return (simple)? n : -1;
+}
+
+// ear-clip the counter-clockwise simple polygon poly[0..n)
+bool Problem::clipEars(int *poly, int n)
+{
+    while(n > 3) {
+        int     best = -1;
+        double  best_quality = -1.0;
+        for(int i=0; i<n; i++) {
+            int a = poly[(i+n-1)%n];
+            int b = poly[i];
+            int c = poly[(i+1)%n];
+            if(orient(a, b, c) <= 0) {
+                if(!ok)     return false;
+                continue;
+            }
+            bool ear = true;
+            for(int j=0; j<n && ear; j++) {
+                int p = poly[j];
+                if(p == a || p == b || p == c)  continue;
+                if(orient(a, b, p) >= 0 &&
+                   orient(b, c, p) >= 0 &&
+                   orient(c, a, p) >= 0)
+                    ear = false;
+                if(!ok)     return false;
+            }
+            if(!ear)    continue;
+            
+            // prefer fat ears: area relative to squared edge lengths
+            const double *pa = in.coords[a];
+            const double *pb = in.coords[b];
+            const double *pc = in.coords[c];
+            double area = (pb[0]-pa[0])*(pc[1]-pa[1]) -
+                          (pb[1]-pa[1])*(pc[0]-pa[0]);
+            double lensq = 0.0;
+            for(int d=0; d<2; d++) {
+                lensq += (pb[d]-pa[d])*(pb[d]-pa[d]) +
+                         (pc[d]-pb[d])*(pc[d]-pb[d]) +
+                         (pa[d]-pc[d])*(pa[d]-pc[d]);
+            }
+            double quality = area / lensq;
+            if(quality > best_quality) {
+                best_quality = quality;
+                best = i;
+            }
+        }
+        if(best < 0)
+            return false;
+        
+        int *tri = out->triangles[out->numTriangles++];
+        tri[0] = poly[(best+n-1)%n];
+        tri[1] = poly[best];
+        tri[2] = poly[(best+1)%n];
+        for(int i=best; i<n-1; i++)
+            poly[i] = poly[i+1];
+        n--;
+    }
+    if(orient(poly[0], poly[1], poly[2]) <= 0)
+        return false;
+    int *tri = out->triangles[out->numTriangles++];
+    tri[0] = poly[0];
+    tri[1] = poly[1];
+    tri[2] = poly[2];
+    return true;
+}
+
+// Flip edges that aren't segments until the triangulation is
+// constrained Delaunay, as far as the incircle filter can tell.
+// Uncertain cases are left alone; either choice is a valid result
+void Problem::delaunayFlips()
+{
+    int nflips = 0;
+    bool flipped = true;
+    while(flipped && nflips < MAX_FLIPS) {
+        flipped = false;
+        for(int t0=0; t0<out->numTriangles; t0++) {
+          for(int e0=0; e0<3 && !flipped; e0++) {
+            int *tri0 = out->triangles[t0];
+            int a = tri0[e0];
+            int b = tri0[(e0+1)%3];
+            int c = tri0[(e0+2)%3];
+            if(graph.isSeg[a][b])   continue;
+            // find the triangle across edge ab
+            for(int t1=0; t1<out->numTriangles && !flipped; t1++) {
+                int *tri1 = out->triangles[t1];
+                for(int e1=0; e1<3; e1++) {
+                    if(tri1[e1] != b || tri1[(e1+1)%3] != a)    continue;
+                    int d = tri1[(e1+2)%3];
+                    if(!inCircle(a, b, c, d))   break;
+                    bool okBefore = ok;
+                    bool convex = orient(c, a, d) > 0 &&
+                                  orient(d, b, c) > 0;
+                    ok = okBefore;
+                    if(!convex)     break;
+                    tri0[0] = c;  tri0[1] = a;  tri0[2] = d;
+                    tri1[0] = d;  tri1[1] = b;  tri1[2] = c;
+                    flipped = true;
+                    nflips++;
+                    break;
+                }
+            }
+          }
+        }
+    }
+}
+
+bool Problem::run()
+{
+    out->numTriangles = 0;
+    if(!buildGraph())
+        return false;
+    
+    // Extract every face.  For a connected graph,
+    // V - E + F = 2, counting the outer face
+    int faces[MAX_FACES][MAX_POINTS];
+    int faceSizes[MAX_FACES];
+    int nFaces = 0;
+    for(int v=0; v<in.numPoints; v++) {
+        for(int k=0; k<graph.degree[v]; k++) {
+            if(graph.visited[v][k])     continue;
+            if(nFaces >= MAX_FACES)     return false;
+            int n = traceFace(v, k, faces[nFaces]);
+            if(n < 3)                   return false;
+            faceSizes[nFaces++] = n;
+        }
+    }
+    if(in.numPoints - in.numSegments + nFaces != 2)
+        return false;
+    
+    // The orientation at a face's lexicographically smallest vertex
+    // is the orientation of the whole face.  Exactly one face, the
+    // outer one, should be clockwise.
+    int nClockwise = 0;
+    for(int f=0; f<nFaces; f++) {
+        int *face = faces[f];
+        int n = faceSizes[f];
+        int m = 0;
+        for(int i=1; i<n; i++) {
+            const double *pi = in.coords[face[i]];
+            const double *pm = in.coords[face[m]];
+            if(pi[0] < pm[0] || (pi[0] == pm[0] && pi[1] < pm[1]))
+                m = i;
+        }
+        int o = orient(face[(m+n-1)%n], face[m], face[(m+1)%n]);
+        if(!ok || o == 0)   return false;
+        if(o < 0) {
+            nClockwise++;
+            faceSizes[f] = 0; // don't triangulate the outside
+        }
+    }
+    if(nClockwise != 1)
+        return false;
+    
+    for(int f=0; f<nFaces; f++) {
+        if(faceSizes[f] == 0)   continue;
+        if(!clipEars(faces[f], faceSizes[f]) || !ok)
+            return false;
+    }
+    
+    delaunayFlips();
+    return true;
+}
+
+} // end anonymous namespace
+
+bool triangulate(const Input &in, Output *out)
+{
+    if(in.numPoints < 3 || in.numPoints > MAX_POINTS ||
+       in.numSegments > MAX_SEGMENTS)
+        return false;
+    Problem prob(in, out);
+    return prob.run() && prob.ok;
+}
+
+} // end namespace SmallCDT
@@ -0,0 +1,69 @@
+// +-------------------------------------------------------------------------
+// | smallcdt.h
+// | 
+// | Author: Gilbert Bernstein
+// +-------------------------------------------------------------------------
+// | COPYRIGHT:
+// |    Copyright Gilbert Bernstein 2013
+// |    See the included COPYRIGHT file for further details.
+// |    
+// |    This file is part of the Cork library.
+// |
+// |    Cork is free software: you can redistribute it and/or modify
+// |    it under the terms of the GNU Lesser General Public License as
+// |    published by the Free Software Foundation, either version 3 of
+// |    the License, or (at your option) any later version.
+// |
+// |    Cork is distributed in the hope that it will be useful,
+// |    but WITHOUT ANY WARRANTY; without even the implied warranty of
+// |    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// |    GNU Lesser General Public License for more details.
+// |
+// |    You should have received a copy 
+// |    of the GNU Lesser General Public License
+// |    along with Cork.  If not, see <http://www.gnu.org/licenses/>.
+// +-------------------------------------------------------------------------
+#pragma once
+
+#include "prelude.h"
+
+// SmallCDT triangulates the small planar straight line graphs that
+// come up when subdividing one triangle along its intersection curves:
+// the triangle's boundary, plus a few segments between the points on
+// and inside it.  It only uses fixed size storage.
+//
+// Every orientation test is certified with a floating point error
+// bound.  Whenever a test can't be certified, or the input falls
+// outside the simple cases handled here, triangulate() returns false
+// and the caller should fall back on the general Triangle library.
+
+namespace SmallCDT {
+
+static const int MAX_POINTS     = 16;
+static const int MAX_SEGMENTS   = 32;
+static const int MAX_TRIANGLES  = 2 * MAX_POINTS;
+
+struct Input
+{
+    int     numPoints;
+    double  coords[MAX_POINTS][2];
+    // bitmask of the lines each point lies on exactly.  Points that
+    // share a line are known to be collinear without any arithmetic
+    uint    lines[MAX_POINTS];
+    
+    int     numSegments;
+    int     segments[MAX_SEGMENTS][2];
+};
+
+struct Output
+{
+    int     numTriangles;
+    int     triangles[MAX_TRIANGLES][3]; // counter-clockwise
+};
+
+// Triangulate every bounded face of the graph formed by the segments.
+// The graph must be connected, and its outer boundary must be a simple
+// polygon.  Returns false if the case was not handled
+bool triangulate(const Input &in, Output *out);
+
+} // end namespace SmallCDT
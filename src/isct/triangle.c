@@ -640,17 +640,29 @@ struct memorypool {
 
 
 /* Global constants.                                                         */
+/*                                                                           */
+/* These are (re)initialized at the start of every call to triangulate(),   */
+/*   so each thread keeps its own copy.  That way, separate threads may      */
+/*   run triangulate() at the same time.                                     */
+
+#if defined(_MSC_VER)
+#define THREADLOCAL __declspec(thread)
+#elif defined(__GNUC__)
+#define THREADLOCAL __thread
+#else /* no known thread-local storage; triangulate() is not reentrant */
+#define THREADLOCAL
+#endif
 
-REAL splitter;       /* Used to split REAL factors for exact multiplication. */
-REAL epsilon;                             /* Floating-point machine epsilon. */
-REAL resulterrbound;
-REAL ccwerrboundA, ccwerrboundB, ccwerrboundC;
-REAL iccerrboundA, iccerrboundB, iccerrboundC;
-REAL o3derrboundA, o3derrboundB, o3derrboundC;
+THREADLOCAL REAL splitter;       /* Used to split REAL factors for exact mult. */
+THREADLOCAL REAL epsilon;                   /* Floating-point machine epsilon. */
+THREADLOCAL REAL resulterrbound;
+THREADLOCAL REAL ccwerrboundA, ccwerrboundB, ccwerrboundC;
+THREADLOCAL REAL iccerrboundA, iccerrboundB, iccerrboundC;
+THREADLOCAL REAL o3derrboundA, o3derrboundB, o3derrboundC;
 
 /* Random number seed is not constant, but I've made it global anyway.       */
 
-unsigned long randomseed;                     /* Current random number seed. */
+THREADLOCAL unsigned long randomseed;           /* Current random number seed. */
 
 
 /* Mesh data structure.  Triangle operates on only one mesh, but the mesh    */
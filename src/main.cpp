@@ -36,6 +36,7 @@ using std::cerr;
 using std::endl;
 #include <sstream>
 using std::stringstream;
+#include <fstream>
 using std::string;
 
 using std::ostream;
@@ -215,13 +216,40 @@ void CmdList::runCommands(std::vector<string>::iterator &arg_it,
 }
 
 
+// options passed to every operation; modified by commands like -threads
+CorkOptions cli_options;
+// filled in by each operation once -stats is given
+CorkStats cli_stats;
+
+void printStats(const CorkStats &stats)
+{
+    cout << "candidate pairs:   " << stats.candidate_pairs << endl;
+    cout << "predicate calls:   " << stats.predicate_calls << endl;
+    cout << "filter pass rate:  " << 100.0 * stats.filterPassRate()
+                                  << "%" << endl;
+    cout << "exact fallbacks:   " << stats.exact_fallbacks << endl;
+    cout << "degeneracies:      " << stats.degeneracies << endl;
+    cout << "perturb retries:   " << stats.perturb_retries << endl;
+    cout << "glue points:       " << stats.glue_points << endl;
+    cout << "tris subdivided:   " << stats.tris_subdivided << endl;
+    cout << "find time:         " << stats.find_ms << " ms" << endl;
+    cout << "subdivide time:    " << stats.subdivide_ms << " ms" << endl;
+    cout << "classify time:     " << stats.classify_ms << " ms" << endl;
+    cout << "delete/flip time:  " << stats.delete_flip_ms << " ms" << endl;
+    cout << "total time:        " << stats.total_ms << " ms" << endl;
+    cout << "scratch peak:      " << stats.arena_peak_bytes / 1024
+         << " KiB" << endl;
+}
+
+typedef bool (*CorkBinaryOp)(CorkTriMesh in0, CorkTriMesh in1,
+                             CorkTriMesh *out, const CorkOptions &options);
+
 std::function< void(
     std::vector<string>::iterator &,
     const std::vector<string>::iterator &
 ) >
 genericBinaryOp(
-    std::function< void(CorkTriMesh in0, CorkTriMesh in1, CorkTriMesh *out) >
-        binop
+    CorkBinaryOp binop
 ) {
     return [binop]
     (std::vector<string>::iterator &args,
@@ -239,7 +267,10 @@ genericBinaryOp(
         loadMesh(*args, &in1);
         args++;
         
-        binop(in0, in1, &out);
+        bool success = binop(in0, in1, &out, cli_options);
+        if(cli_options.stats)
+            printStats(*cli_options.stats);
+        if(!success) { cerr << "operation failed" << endl; exit(1); }
         
         if(args == end) { cerr << "too few args" << endl; exit(1); }
         saveMesh(*args, out);
@@ -296,6 +327,150 @@ int main(int argc, char *argv[])
         delete[] in.vertices;
         delete[] in.triangles;
     });
+    cmds.regCmd("classify",
+    "-classify in0 in1      Determine whether the surfaces of the two\n"
+    "                       solids intersect, and if not, whether one\n"
+    "                       contains the other, or only some of its parts",
+    [](std::vector<string>::iterator &args,
+       const std::vector<string>::iterator &end) {
+        CorkTriMesh in0;
+        CorkTriMesh in1;
+        if(args == end) { cerr << "too few args" << endl; exit(1); }
+        loadMesh(*args, &in0);
+        args++;
+        if(args == end) { cerr << "too few args" << endl; exit(1); }
+        loadMesh(*args, &in1);
+        args++;
+        
+        switch(classify(in0, in1)) {
+        case CORK_INTERSECTING: cout << "INTERSECTING" << endl;     break;
+        case CORK_APART:        cout << "APART" << endl;            break;
+        case CORK_IN0_IN_IN1:   cout << "in0 INSIDE in1" << endl;   break;
+        case CORK_IN1_IN_IN0:   cout << "in1 INSIDE in0" << endl;   break;
+        case CORK_PARTLY_INSIDE:
+            cout << "PARTLY INSIDE" << endl;
+            break;
+        }
+        
+        delete[] in0.vertices;
+        delete[] in0.triangles;
+        delete[] in1.vertices;
+        delete[] in1.triangles;
+    });
+    cmds.regCmd("curves",
+    "-curves in0 in1 out    Find the curves along which the surfaces of\n"
+    "                       in0 and in1 intersect, and output them as\n"
+    "                       polylines in an .obj file",
+    [](std::vector<string>::iterator &args,
+       const std::vector<string>::iterator &end) {
+        CorkTriMesh in0;
+        CorkTriMesh in1;
+        if(args == end) { cerr << "too few args" << endl; exit(1); }
+        loadMesh(*args, &in0);
+        args++;
+        if(args == end) { cerr << "too few args" << endl; exit(1); }
+        loadMesh(*args, &in1);
+        args++;
+        
+        CorkPolylines curves;
+        bool success = computeIntersectionCurves(in0, in1, &curves,
+                                                 cli_options);
+        if(cli_options.stats)
+            printStats(*cli_options.stats);
+        if(!success) { cerr << "operation failed" << endl; exit(1); }
+        
+        if(args == end) { cerr << "too few args" << endl; exit(1); }
+        std::ofstream out(*args);
+        if(!out) {
+            cerr << "Unable to write to " << *args << endl;
+            exit(1);
+        }
+        args++;
+        for(uint i=0; i<curves.n_points; i++) {
+            out << "v " << curves.points[3*i+0] << " "
+                        << curves.points[3*i+1] << " "
+                        << curves.points[3*i+2] << endl;
+        }
+        // .obj indices start at 1
+        for(uint k=0; k<curves.n_curves; k++) {
+            out << "l";
+            for(uint i=curves.curve_starts[k]; i<curves.curve_starts[k+1];
+                i++)
+                out << " " << i+1;
+            if(curves.closed[k])
+                out << " " << curves.curve_starts[k]+1;
+            out << endl;
+        }
+        
+        freeCorkPolylines(&curves);
+        
+        delete[] in0.vertices;
+        delete[] in0.triangles;
+        delete[] in1.vertices;
+        delete[] in1.triangles;
+    });
+    cmds.regCmd("threads",
+    "-threads n             Use n threads to find intersections in the\n"
+    "                       commands that follow (0 = one per hardware\n"
+    "                       thread; the default is 1)",
+    [](std::vector<string>::iterator &args,
+       const std::vector<string>::iterator &end) {
+        if(args == end) { cerr << "too few args" << endl; exit(1); }
+        stringstream arg(*args);
+        int n_threads = -1;
+        arg >> n_threads;
+        if(arg.fail() || n_threads < 0) {
+            cerr << "-threads expects a non-negative integer" << endl;
+            exit(1);
+        }
+        args++;
+        
+        cli_options.n_threads = uint(n_threads);
+    });
+    cmds.regCmd("crossonly",
+    "-crossonly             In the Boolean commands that follow, only look\n"
+    "                       for intersections between in0 and in1.  Faster,\n"
+    "                       but requires both inputs to be solid",
+    [](std::vector<string>::iterator &,
+       const std::vector<string>::iterator &) {
+        cli_options.cross_operand_only = true;
+    });
+    cmds.regCmd("overlaponly",
+    "-overlaponly           In the Boolean commands that follow, only\n"
+    "                       resolve triangles near the overlap of the\n"
+    "                       inputs' bounding boxes.  Faster when the\n"
+    "                       overlap is small, but requires both inputs\n"
+    "                       to be solid",
+    [](std::vector<string>::iterator &,
+       const std::vector<string>::iterator &) {
+        cli_options.overlap_only = true;
+    });
+    cmds.regCmd("sah",
+    "-sah leafsize          In the commands that follow, build bounding\n"
+    "                       volume hierarchies with the surface area\n"
+    "                       heuristic and at most leafsize entries per leaf",
+    [](std::vector<string>::iterator &args,
+       const std::vector<string>::iterator &end) {
+        if(args == end) { cerr << "too few args" << endl; exit(1); }
+        stringstream arg(*args);
+        int leaf_size = -1;
+        arg >> leaf_size;
+        if(arg.fail() || leaf_size < 1) {
+            cerr << "-sah expects a positive integer" << endl;
+            exit(1);
+        }
+        args++;
+        
+        cli_options.sah_bvh = true;
+        cli_options.bvh_leaf_size = uint(leaf_size);
+    });
+    cmds.regCmd("stats",
+    "-stats                 Print predicate counters and timings for each\n"
+    "                       of the commands that follow",
+    [](std::vector<string>::iterator &,
+       const std::vector<string>::iterator &) {
+        cli_options.stats = &cli_stats;
+    });
     cmds.regCmd("union",
     "-union in0 in1 out     Compute the Boolean union of in0 and in1,\n"
     "                       and output the result",
@@ -313,6 +488,133 @@ int main(int argc, char *argv[])
     "                       and output the result\n"
     "                       (aka. the symmetric difference)",
     genericBinaryOp(computeSymmetricDifference));
+    cmds.regCmd("unionall",
+    "-unionall n in1 .. inn out\n"
+    "                       Compute the Boolean union of the n inputs\n"
+    "                       all at once, and output the result",
+    [](std::vector<string>::iterator &args,
+       const std::vector<string>::iterator &end) {
+        if(args == end) { cerr << "too few args" << endl; exit(1); }
+        stringstream arg(*args);
+        int n = -1;
+        arg >> n;
+        if(arg.fail() || n < 1) {
+            cerr << "-unionall expects a positive number of inputs" << endl;
+            exit(1);
+        }
+        args++;
+        
+        std::vector<CorkTriMesh> in(n);
+        for(int k=0; k<n; k++) {
+            if(args == end) { cerr << "too few args" << endl; exit(1); }
+            loadMesh(*args, &in[k]);
+            args++;
+        }
+        
+        CorkTriMesh out;
+        bool success = computeNaryUnion(in.data(), n, &out, cli_options);
+        if(cli_options.stats)
+            printStats(*cli_options.stats);
+        if(!success) { cerr << "operation failed" << endl; exit(1); }
+        
+        if(args == end) { cerr << "too few args" << endl; exit(1); }
+        saveMesh(*args, out);
+        args++;
+        
+        freeCorkTriMesh(&out);
+        
+        for(CorkTriMesh &mesh : in) {
+            delete[] mesh.vertices;
+            delete[] mesh.triangles;
+        }
+    });
+    cmds.regCmd("csg",
+    "-csg n in1 .. inn expr out\n"
+    "                       Evaluate the CSG expression expr over the n\n"
+    "                       inputs all at once, and output the result.\n"
+    "                       expr is in postfix notation, with inputs\n"
+    "                       numbered from 1 and the operators + (union),\n"
+    "                       - (difference), * (intersection) and ^ (XOR),\n"
+    "                       e.g. \"1 2 + 3 -\" for (in1 U in2) - in3",
+    [](std::vector<string>::iterator &args,
+       const std::vector<string>::iterator &end) {
+        if(args == end) { cerr << "too few args" << endl; exit(1); }
+        stringstream arg(*args);
+        int n = -1;
+        arg >> n;
+        if(arg.fail() || n < 1) {
+            cerr << "-csg expects a positive number of inputs" << endl;
+            exit(1);
+        }
+        args++;
+        
+        std::vector<CorkTriMesh> in(n);
+        for(int k=0; k<n; k++) {
+            if(args == end) { cerr << "too few args" << endl; exit(1); }
+            loadMesh(*args, &in[k]);
+            args++;
+        }
+        
+        // each token pushes a node; an operator pops its two operands
+        if(args == end) { cerr << "too few args" << endl; exit(1); }
+        stringstream expr(*args);
+        std::vector<CorkCsgNode> nodes;
+        std::vector<uint> stack;
+        string token;
+        while(expr >> token) {
+            CorkCsgNode node = { CorkCsgNode::OPERAND, 0, 0, 0 };
+            if(token == "+")        node.op = CorkCsgNode::UNION;
+            else if(token == "-")   node.op = CorkCsgNode::DIFFERENCE;
+            else if(token == "*")   node.op = CorkCsgNode::INTERSECTION;
+            else if(token == "^")   node.op = CorkCsgNode::SYMMETRIC_DIFFERENCE;
+            else {
+                stringstream num(token);
+                int k = -1;
+                num >> k;
+                if(num.fail() || k < 1 || k > n) {
+                    cerr << "-csg: " << token
+                         << " is neither an input nor an operator" << endl;
+                    exit(1);
+                }
+                node.operand = uint(k-1);
+            }
+            if(node.op != CorkCsgNode::OPERAND) {
+                if(stack.size() < 2) {
+                    cerr << "-csg: " << token << " is missing operands"
+                         << endl;
+                    exit(1);
+                }
+                node.right = stack.back();  stack.pop_back();
+                node.left  = stack.back();  stack.pop_back();
+            }
+            stack.push_back(nodes.size());
+            nodes.push_back(node);
+        }
+        if(stack.size() != 1) {
+            cerr << "-csg: the expression must have exactly one result"
+                 << endl;
+            exit(1);
+        }
+        args++;
+        
+        CorkTriMesh out;
+        bool success = computeCsg(in.data(), n, nodes.data(), nodes.size(),
+                                  &out, cli_options);
+        if(cli_options.stats)
+            printStats(*cli_options.stats);
+        if(!success) { cerr << "operation failed" << endl; exit(1); }
+        
+        if(args == end) { cerr << "too few args" << endl; exit(1); }
+        saveMesh(*args, out);
+        args++;
+        
+        freeCorkTriMesh(&out);
+        
+        for(CorkTriMesh &mesh : in) {
+            delete[] mesh.vertices;
+            delete[] mesh.triangles;
+        }
+    });
     cmds.regCmd("resolve",
     "-resolve in0 in1 out   Intersect the two meshes in0 and in1,\n"
     "                       and output the connected mesh with those\n"
@@ -26,6 +26,30 @@
 #pragma once
 
 #include <queue>
+#include <memory>
+
+static inline double triArea(
+    Vec3d a, Vec3d b, Vec3d c
+) {
+    return len(cross(b-a, c-a));
+}
+
+
+// what prepareBoolOperand() works out about an operand on its own,
+// before it meets any other operand
+template<class VertData, class TriData>
+struct Mesh<VertData,TriData>::OperandCache
+{
+    BBox3d                          box;
+    std::vector<BBox3d>             tri_boxes;
+    // the connected components, numbered from 0.  Each has a box and
+    // the largest of its triangles, from which rays are cast
+    std::vector<uint>               comp_of_tri;
+    std::vector<BBox3d>             comp_boxes;
+    std::vector<uint>               comp_best_tid;
+    // of all the triangles; null if there are none
+    std::unique_ptr< AABVH<uint> >  tri_bvh;
+};
 
 template<class VertData, class TriData>
 class Mesh<VertData,TriData>::BoolProblem
@@ -35,14 +59,57 @@ public:
     {}
     virtual ~BoolProblem() {}
     
+    // fill in the mesh's operand_cache
+    void prepareOperand();
+    
     // do things
-    void doSetup(Mesh &rhs);
+    // The setups return false if the intersections couldn't be
+    // resolved (see resolveIntersections()); then don't go on
+    bool doSetup(const Mesh &rhs);
+    // the same for any number of operands.  The mesh is operand 0
+    // and rhs[k] is operand k+1.  Afterwards, a triangle's
+    // bool_alg_data is whatever classify returns for it, given its
+    // operand and which of the other operands it lies inside
+    bool doNarySetup(
+        const std::vector<const Mesh*> &rhs,
+        std::function<byte(uint operand, std::vector<bool> &inside)> classify
+    );
+    
+    // make intersections explicit, but only among triangles
+    // touching the overlap of the two operands' bounding boxes;
+    // the rest of the mesh is left untouched
+    bool resolveOverlapIntersections();
     
     // choose what to remove
     enum TriCode { KEEP_TRI, DELETE_TRI, FLIP_TRI };
     void doDeleteAndFlip(
         std::function<TriCode(byte bool_alg_data)> classify
     );
+    
+    // Do the surfaces of the mesh and rhs meet?  Nothing is resolved,
+    // and the search stops at the first meeting found.  Unless exact,
+    // any triangles of the two operands with overlapping bounding
+    // boxes are taken to meet
+    bool surfacesMeet(const Mesh &rhs, bool exact);
+    // how two operands whose surfaces don't meet are arranged
+    Nesting findNesting(const Mesh &rhs);
+    // For two operands whose surfaces don't meet: whether each triangle
+    // of the mesh (inside[0]) and of rhs (inside[1]) lies inside the
+    // other operand.  Each connected component of an operand lies
+    // entirely inside or outside of the other, so one ray decides it
+    void findContainment(const Mesh &rhs, std::vector<bool> inside[2]);
+    // Copies the triangles of the mesh and rhs touching the overlap of
+    // their bounding boxes, i.e. the only ones that can meet the other
+    // operand, into sub.  Each is labeled with its operand
+    void copyOverlap(const Mesh &rhs, Mesh *sub);
+    
+    // doSetup() and doDeleteAndFlip(), unless the surfaces don't meet.
+    // Then every triangle of a connected component is classified the
+    // same, and the result is assembled from the operands directly
+    bool doBoolOp(
+        const Mesh &rhs,
+        std::function<TriCode(byte bool_alg_data)> classify
+    );
 
 private: // methods
     struct BoolEdata {
@@ -52,6 +119,9 @@ private: // methods
     inline byte& boolData(uint tri_id) {
         return mesh->tris[tri_id].data.bool_alg_data;
     }
+    inline uint& operandOf(uint tri_id) {
+        return mesh->tris[tri_id].data.bool_operand;
+    }
     
     void populateECache()
     {
@@ -60,9 +130,9 @@ private: // methods
         // label some of the edges as intersection edges and others as not
         ecache.for_each([&](uint i, uint j, EGraphEntry<BoolEdata> &entry) {
             entry.data.is_isct = false;
-            byte operand = boolData(entry.tids[0]);
+            uint operand = operandOf(entry.tids[0]);
             for(uint k=1; k<entry.tids.size(); k++) {
-                if(boolData(entry.tids[k]) != operand) {
+                if(operandOf(entry.tids[k]) != operand) {
                     entry.data.is_isct = true;
                     break;
                 }
@@ -93,85 +163,347 @@ private: // methods
         });
     }
     
+    // build one triangle BVH per operand, so that rays cast
+    // against an operand only visit triangles near the ray
     void prepInsideOutsideTests()
     {
+        std::vector< GeomBlob<uint> > tri_geoms[2];
+        for(uint tid=0; tid<mesh->tris.size(); tid++) {
+            const Tri &tri = mesh->tris[tid];
+            Vec3d va = mesh->verts[tri.a].pos;
+            Vec3d vb = mesh->verts[tri.b].pos;
+            Vec3d vc = mesh->verts[tri.c].pos;
+            GeomBlob<uint> blob;
+            blob.id     = tid;
+            blob.bbox   = BBox3d(min(va, min(vb, vc)), max(va, max(vb, vc)));
+            blob.point  = (blob.bbox.minp + blob.bbox.maxp) / 2.0;
+            tri_geoms[boolData(tid) & 1].push_back(blob);
+        }
+        for(uint k=0; k<2; k++) {
+            if(tri_geoms[k].size() > 0)
+                tri_bvhs[k].reset(new AABVH<uint>(tri_geoms[k],
+                    bvhOptions(mesh->isct_options)));
+            else
+                tri_bvhs[k].reset();
+        }
     }
     
-    bool isInside(uint tid, byte operand) {
+    // bounding box of triangle tid of m
+    static BBox3d triBox(const Mesh &m, uint tid) {
+        Vec3d va = m.verts[m.tris[tid].a].pos;
+        Vec3d vb = m.verts[m.tris[tid].b].pos;
+        Vec3d vc = m.verts[m.tris[tid].c].pos;
+        return BBox3d(min(va, min(vb, vc)), max(va, max(vb, vc)));
+    }
+    // a BVH of all of m's triangles, to cast rays against m
+    std::unique_ptr< AABVH<uint> > triBVH(const Mesh &m) {
+        std::vector< GeomBlob<uint> > tri_geoms(m.tris.size());
+        for(uint tid=0; tid<m.tris.size(); tid++) {
+            GeomBlob<uint> &blob = tri_geoms[tid];
+            blob.id     = tid;
+            blob.bbox   = triBox(m, tid);
+            blob.point  = (blob.bbox.minp + blob.bbox.maxp) / 2.0;
+        }
+        return std::unique_ptr< AABVH<uint> >(new AABVH<uint>(tri_geoms,
+            bvhOptions(mesh->isct_options)));
+    }
+    // bound m and each of its triangles
+    static void boundOperand(const Mesh &m, OperandCache *desc) {
+        desc->tri_boxes.resize(m.tris.size());
+        for(uint tid=0; tid<m.tris.size(); tid++) {
+            desc->tri_boxes[tid] = triBox(m, tid);
+            desc->box = convex(desc->box, desc->tri_boxes[tid]);
+        }
+    }
+    // label the connected components of m, once it's bounded
+    static void findComponents(const Mesh &m, OperandCache *desc) {
+        UnionFind uf(m.verts.size());
+        for(const Tri &tri : m.tris) {
+            uf.unionIds(tri.a, tri.b);
+            uf.unionIds(tri.a, tri.c);
+        }
+        std::vector<uint>   comp_of_root(m.verts.size(), INVALID_ID);
+        std::vector<double> best_area;
+        desc->comp_of_tri.resize(m.tris.size());
+        for(uint tid=0; tid<m.tris.size(); tid++) {
+            uint &comp = comp_of_root[uf.find(m.tris[tid].a)];
+            Vec3d va = m.verts[m.tris[tid].a].pos;
+            Vec3d vb = m.verts[m.tris[tid].b].pos;
+            Vec3d vc = m.verts[m.tris[tid].c].pos;
+            double area = triArea(va, vb, vc);
+            if(comp == INVALID_ID) {
+                comp = desc->comp_boxes.size();
+                desc->comp_boxes.push_back(desc->tri_boxes[tid]);
+                desc->comp_best_tid.push_back(tid);
+                best_area.push_back(area);
+            } else {
+                desc->comp_boxes[comp] = convex(desc->comp_boxes[comp],
+                                                desc->tri_boxes[tid]);
+                if(area > best_area[comp]) {
+                    best_area[comp] = area;
+                    desc->comp_best_tid[comp] = tid;
+                }
+            }
+            desc->comp_of_tri[tid] = comp;
+        }
+    }
+    // The descriptions of the mesh (desc[0]) and rhs (desc[1]): the
+    // prepared ones where there are, otherwise ones worked out in
+    // scratch, with the components only if asked for
+    void describeOperands(const Mesh &rhs, bool components,
+                          OperandCache scratch[2],
+                          const OperandCache *desc[2]) {
+        const Mesh *operands[2] = { mesh, &rhs };
+        for(uint k=0; k<2; k++) {
+            const Mesh &m = *operands[k];
+            if(m.operand_cache) {
+                desc[k] = m.operand_cache.get();
+                continue;
+            }
+            boundOperand(m, &scratch[k]);
+            if(components)
+                findComponents(m, &scratch[k]);
+            desc[k] = &scratch[k];
+        }
+    }
+    // The overlap of two operands' boxes, padded by how far resolving
+    // intersections may move a vertex, so that a triangle left out of
+    // it can't come to cross one inside.  Empty if nothing is that close
+    static BBox3d paddedOverlap(const BBox3d &box0, const BBox3d &box1) {
+        if(isEmpty(box0) || isEmpty(box1))
+            return isct(box0, box1);
+        BBox3d both = convex(box0, box1);
+        double pad = IsctProblem::perturbBound(
+            std::max(max(abs(both.minp)), max(abs(both.maxp))));
+        BBox3d overlap = isct(box0, box1);
+        overlap.minp -= Vec3d(pad, pad, pad);
+        overlap.maxp += Vec3d(pad, pad, pad);
+        return overlap;
+    }
+    
+    // a ray from the center of the triangle in a random direction
+    Ray3d rayFrom(const Mesh &m, uint tid) {
         // find the point to trace outward from...
         Vec3d p(0,0,0);
-        p += mesh->verts[mesh->tris[tid].a].pos;
-        p += mesh->verts[mesh->tris[tid].b].pos;
-        p += mesh->verts[mesh->tris[tid].c].pos;
+        p += m.verts[m.tris[tid].a].pos;
+        p += m.verts[m.tris[tid].b].pos;
+        p += m.verts[m.tris[tid].c].pos;
         p /= 3.0;
         // ok, we've got the point, now let's pick a direction
         Ray3d r;
         r.p = p;
-        r.r = Vec3d(drand(0.5,1.5), drand(0.5,1.5), drand(0.5, 1.5));
+        r.r = Vec3d(rand_source.drand(0.5,1.5),
+                    rand_source.drand(0.5,1.5),
+                    rand_source.drand(0.5,1.5));
+        return r;
+    }
+    
+    // +1 if the ray leaves through the triangle, -1 if it enters,
+    // and 0 if it misses
+    int crossing(const Mesh &m, const Ray3d &r, uint tid) {
+        const Tri &tri = m.tris[tid];
+        
+        double flip = 1.0;
+        uint   a = tri.a;
+        uint   b = tri.b;
+        uint   c = tri.c;
+        Vec3d va = m.verts[a].pos;
+        Vec3d vb = m.verts[b].pos;
+        Vec3d vc = m.verts[c].pos;
+        // normalize vertex order (to prevent leaks)
+        if(a > b) { std::swap(a, b); std::swap(va, vb); flip = -flip; }
+        if(b > c) { std::swap(b, c); std::swap(vb, vc); flip = -flip; }
+        if(a > b) { std::swap(a, b); std::swap(va, vb); flip = -flip; }
         
+        double t;
+        Vec3d bary;
+        if(!isct_ray_triangle(r, va, vb, vc, &t, &bary))
+            return 0;
+        Vec3d normal = flip * cross(vb - va, vc - va);
+        return (dot(normal, r.r) > 0.0)? 1 : -1; // UNSAFE
+    }
+    
+    bool isInside(uint tid, byte operand) {
+        Ray3d r = rayFrom(*mesh, tid);
         
         int winding = 0;
-        // pass all triangles over ray
-        for(Tri &tri : mesh->tris) {
-            // ignore triangles from the same operand surface
-            if((tri.data.bool_alg_data & 1) == operand)   continue;
-            
-            double flip = 1.0;
-            uint   a = tri.a;
-            uint   b = tri.b;
-            uint   c = tri.c;
-            Vec3d va = mesh->verts[a].pos;
-            Vec3d vb = mesh->verts[b].pos;
-            Vec3d vc = mesh->verts[c].pos;
-            // normalize vertex order (to prevent leaks)
-            if(a > b) { std::swap(a, b); std::swap(va, vb); flip = -flip; }
-            if(b > c) { std::swap(b, c); std::swap(vb, vc); flip = -flip; }
-            if(a > b) { std::swap(a, b); std::swap(va, vb); flip = -flip; }
-            
-            double t;
-            Vec3d bary;
-            if(isct_ray_triangle(r, va, vb, vc, &t, &bary)) {
-                Vec3d normal = flip * cross(vb - va, vc - va);
-                if(dot(normal, r.r) > 0.0) { // UNSAFE
-                    winding++;
-                } else {
-                    winding--;
-                }
-            }
-        }
+        // pass all triangles of the other operand surface over the ray
+        AABVH<uint> *bvh = tri_bvhs[1 - (operand & 1)].get();
+        if(!bvh)
+            return false;
+        bvh->for_each_in_ray(r, [&](uint other_tid) {
+            winding += crossing(*mesh, r, other_tid);
+        });
         
         // now, we've got a winding number to work with...
         return winding > 0;
     }
     
+    // is triangle tid of src inside the other operand, other?
+    // Without a BVH of other's triangles, they are all passed over
+    // the ray, which is cheaper than building one for a single test
+    bool isInside(const Mesh &src, uint tid, const Mesh &other,
+                  const AABVH<uint> *other_bvh = nullptr) {
+        Ray3d r = rayFrom(src, tid);
+        
+        int winding = 0;
+        if(other_bvh) {
+            other_bvh->for_each_in_ray(r, [&](uint other_tid) {
+                winding += crossing(other, r, other_tid);
+            });
+        } else {
+            for(uint other_tid=0; other_tid<other.tris.size(); other_tid++)
+                winding += crossing(other, r, other_tid);
+        }
+        return winding > 0;
+    }
+    
+    // which operands, other than its own, is the triangle inside?
+    // The ray is cast against each operand as given, operands[k],
+    // using the box and BVH in descs[k].  The operands found are
+    // listed in containing
+    void insideOthers(uint tid,
+                      const std::vector<const Mesh*> &operands,
+                      const std::vector<const OperandCache*> &descs,
+                      std::vector<uint> &containing) {
+        Ray3d r = rayFrom(*mesh, tid);
+        uint  own = operandOf(tid);
+        
+        containing.clear();
+        for(uint k=0; k<operands.size(); k++) {
+            const OperandCache &desc = *descs[k];
+            if(k == own || !desc.tri_bvh || !isIn(r.p, desc.box))
+                continue;
+            int winding = 0;
+            desc.tri_bvh->for_each_in_ray(r, [&](uint other_tid) {
+                winding += crossing(*operands[k], r, other_tid);
+            });
+            if(winding > 0)
+                containing.push_back(k);
+        }
+    }
+    
 private: // data
     Mesh                        *mesh;
     EGraphCache<BoolEdata>      ecache;
+    RandomSource                rand_source; // picks ray directions
+    std::unique_ptr< AABVH<uint> >  tri_bvhs[2]; // one per operand
 };
 
 
-static inline double triArea(
-    Vec3d a, Vec3d b, Vec3d c
-) {
-    return len(cross(b-a, c-a));
+template<class VertData, class TriData>
+bool Mesh<VertData,TriData>::BoolProblem::resolveOverlapIntersections()
+{
+    uint Nv = mesh->verts.size();
+    uint Nt = mesh->tris.size();
+    
+    // bound each triangle and each operand
+    std::vector<BBox3d> tri_boxes(Nt);
+    BBox3d operand_boxes[2];
+    for(uint tid=0; tid<Nt; tid++) {
+        Vec3d p0 = mesh->verts[mesh->tris[tid].a].pos;
+        Vec3d p1 = mesh->verts[mesh->tris[tid].b].pos;
+        Vec3d p2 = mesh->verts[mesh->tris[tid].c].pos;
+        tri_boxes[tid] = BBox3d(min(p0, min(p1, p2)), max(p0, max(p1, p2)));
+        BBox3d &opbox = operand_boxes[boolData(tid) & 1];
+        opbox = convex(opbox, tri_boxes[tid]);
+    }
+    
+    // Every intersection point lies in both operands' boxes.
+    BBox3d overlap = paddedOverlap(operand_boxes[0], operand_boxes[1]);
+    if(isEmpty(overlap))
+        return true;
+    
+    // copy the triangles touching the overlap into a separate mesh
+    Mesh sub;
+    sub.isct_options = mesh->isct_options;
+    std::vector<uint> sub_vids;     // sub-mesh vertex -> mesh vertex
+    std::vector<uint> vmap(Nv, INVALID_ID);
+    std::vector<bool> in_sub(Nt, false);
+    for(uint tid=0; tid<Nt; tid++) {
+        if(!hasIsct(tri_boxes[tid], overlap))
+            continue;
+        in_sub[tid] = true;
+        Tri tri = mesh->tris[tid];
+        for(uint k=0; k<3; k++) {
+            uint vid = tri.v[k];
+            if(vmap[vid] == INVALID_ID) {
+                vmap[vid] = sub_vids.size();
+                sub_vids.push_back(vid);
+                sub.verts.push_back(mesh->verts[vid]);
+            }
+            tri.v[k] = vmap[vid];
+        }
+        sub.tris.push_back(tri);
+    }
+    if(sub.tris.size() == 0)
+        return true;
+    
+    bool resolved = (mesh->isct_options.crossOperandOnly)?
+                        sub.resolveOperandIntersections() :
+                        sub.resolveIntersections();
+    mesh->isct_stats.add(sub.isct_stats);
+    if(!resolved)
+        return false;
+    
+    // Resolution keeps the existing vertices, in order, and appends
+    // the new intersection vertices after them.  So the first
+    // sub_vids.size() sub-mesh vertices map back to where they came from
+    ENSURE(sub.verts.size() >= sub_vids.size());
+    std::vector<uint> sub_vmap(sub.verts.size());
+    for(uint i=0; i<sub_vids.size(); i++) {
+        sub_vmap[i] = sub_vids[i];
+        mesh->verts[sub_vids[i]] = sub.verts[i];
+    }
+    for(uint i=sub_vids.size(); i<sub.verts.size(); i++) {
+        sub_vmap[i] = mesh->verts.size();
+        mesh->verts.push_back(sub.verts[i]);
+    }
+    
+    // replace the copied triangles with the resolved ones
+    uint write = 0;
+    for(uint read=0; read<Nt; read++) {
+        if(in_sub[read])    continue;
+        mesh->tris[write] = mesh->tris[read];
+        write++;
+    }
+    mesh->tris.resize(write);
+    for(Tri tri : sub.tris) {
+        for(uint k=0; k<3; k++)
+            tri.v[k] = sub_vmap[tri.v[k]];
+        mesh->tris.push_back(tri);
+    }
+    return true;
 }
 
-
 template<class VertData, class TriData>
-void Mesh<VertData,TriData>::BoolProblem::doSetup(
-    Mesh &rhs
+bool Mesh<VertData,TriData>::BoolProblem::doSetup(
+    const Mesh &rhs
 ) {
     // Label surfaces...
+    // rhs is labeled in the copy appended to the mesh, not in place,
+    // so that the same rhs may be used by several operations at once
     mesh->for_tris([](TriData &tri, VertData&, VertData&, VertData&) {
         tri.bool_alg_data = 0;
+        tri.bool_operand  = 0;
     });
-    rhs.for_tris([](TriData &tri, VertData&, VertData&, VertData&) {
-        tri.bool_alg_data = 1;
-    });
-    
+    uint lhs_ntris = mesh->tris.size();
     mesh->disjointUnion(rhs);
-    mesh->resolveIntersections();
+    for(uint tid=lhs_ntris; tid<mesh->tris.size(); tid++) {
+        boolData(tid)  = 1;
+        operandOf(tid) = 1;
+    }
+    bool resolved;
+    if(mesh->isct_options.overlapOnly)
+        resolved = resolveOverlapIntersections();
+    else if(mesh->isct_options.crossOperandOnly)
+        resolved = mesh->resolveOperandIntersections();
+    else
+        resolved = mesh->resolveIntersections();
+    if(!resolved)
+        return false;
     
+    Timer timer;
     populateECache();
     
     // form connected components;
@@ -205,6 +537,8 @@ void Mesh<VertData,TriData>::BoolProblem::doSetup(
     
     std::vector<bool> visited(mesh->tris.size(), false);
     
+    prepInsideOutsideTests();
+    
     // find the "best" triangle in each component,
     // and ray cast to determine inside-ness vs. outside-ness
     for(auto &comp : components) {
@@ -257,13 +591,342 @@ void Mesh<VertData,TriData>::BoolProblem::doSetup(
             }
         }
     }
+    mesh->isct_stats.classifyMs += timer.stop();
+    return true;
 }
 
 
+template<class VertData, class TriData>
+bool Mesh<VertData,TriData>::BoolProblem::doNarySetup(
+    const std::vector<const Mesh*> &rhs,
+    std::function<byte(uint operand, std::vector<bool> &inside)> classify
+) {
+    // Rays are cast against the operands as given rather than as
+    // resolved, so that the prepared ones' BVHs can be used as they are
+    Mesh lhs;
+    lhs.disjointUnion(*mesh);
+    std::vector<const Mesh*> operands(1, &lhs);
+    operands.insert(operands.end(), rhs.begin(), rhs.end());
+    
+    // Label surfaces...
+    mesh->for_tris([](TriData &tri, VertData&, VertData&, VertData&) {
+        tri.bool_alg_data = 0;
+        tri.bool_operand  = 0;
+    });
+    uint nverts = mesh->verts.size();
+    uint ntris  = mesh->tris.size();
+    for(const Mesh *operand : rhs) {
+        nverts += operand->verts.size();
+        ntris  += operand->tris.size();
+    }
+    mesh->verts.reserve(nverts);
+    mesh->tris.reserve(ntris);
+    for(uint k=0; k<rhs.size(); k++) {
+        uint first = mesh->tris.size();
+        mesh->disjointUnion(*rhs[k]);
+        for(uint tid=first; tid<mesh->tris.size(); tid++) {
+            boolData(tid)  = 0;
+            operandOf(tid) = k+1;
+        }
+    }
+    // The cross-operand and overlap shortcuts tell operands apart
+    // by the low bit of bool_alg_data, so only work for two of them
+    if(!mesh->resolveIntersections())
+        return false;
+    
+    Timer timer;
+    populateECache();
+    
+    // Split each operand into patches bounded by the intersection
+    // curves.  Unlike in the binary case, a patch may be inside
+    // some operands and outside others, so each patch is tested
+    // separately instead of propagating the result across curves.
+    UnionFind uf(mesh->tris.size());
+    ecache.for_each([&](uint, uint, EGraphEntry<BoolEdata> &entry) {
+        if(entry.data.is_isct)
+            return;
+        uint tid0 = entry.tids[0];
+        for(uint k=1; k<entry.tids.size(); k++)
+            uf.unionIds(tid0, entry.tids[k]);
+    });
+    
+    // test the largest triangle of each patch
+    std::vector<uint> best_tid(mesh->tris.size(), uint(-1));
+    std::vector<double> best_area(mesh->tris.size(), -1.0);
+    for(uint tid=0; tid<mesh->tris.size(); tid++) {
+        Vec3d va = mesh->verts[mesh->tris[tid].a].pos;
+        Vec3d vb = mesh->verts[mesh->tris[tid].b].pos;
+        Vec3d vc = mesh->verts[mesh->tris[tid].c].pos;
+        
+        double area = triArea(va, vb, vc);
+        uint patch = uf.find(tid);
+        if(area > best_area[patch]) {
+            best_area[patch] = area;
+            best_tid[patch] = tid;
+        }
+    }
+    
+    // bound the operands that weren't prepared and build their BVHs
+    std::vector<OperandCache> scratch(operands.size());
+    std::vector<const OperandCache*> descs(operands.size());
+    for(uint k=0; k<operands.size(); k++) {
+        const Mesh &m = *operands[k];
+        if(m.operand_cache) {
+            descs[k] = m.operand_cache.get();
+            continue;
+        }
+        boundOperand(m, &scratch[k]);
+        if(m.tris.size() > 0)
+            scratch[k].tri_bvh = triBVH(m);
+        descs[k] = &scratch[k];
+    }
+    
+    std::vector<bool> inside(rhs.size() + 1, false);
+    std::vector<uint> containing;
+    std::vector<byte> patch_data(mesh->tris.size(), 0);
+    for(uint patch=0; patch<mesh->tris.size(); patch++) {
+        uint tid = best_tid[patch];
+        if(tid == uint(-1))
+            continue;
+        insideOthers(tid, operands, descs, containing);
+        for(uint k : containing)
+            inside[k] = true;
+        patch_data[patch] = classify(operandOf(tid), inside);
+        for(uint k : containing)
+            inside[k] = false;
+    }
+    for(uint tid=0; tid<mesh->tris.size(); tid++)
+        boolData(tid) = patch_data[uf.find(tid)];
+    
+    mesh->isct_stats.classifyMs += timer.stop();
+    return true;
+}
+
+template<class VertData, class TriData>
+bool Mesh<VertData,TriData>::BoolProblem::surfacesMeet(
+    const Mesh &rhs, bool exact
+) {
+    // bound each triangle and each operand
+    OperandCache scratch[2];
+    const OperandCache *desc[2];
+    describeOperands(rhs, false, scratch, desc);
+    
+    // Only triangles inside the overlap of the operands' boxes
+    // can meet.  Look for a pair of them with overlapping boxes,
+    // stopping at the first one found.  The triangles of one operand
+    // are looked up in the BVH of the other, if it was prepared, or
+    // else in one built of the other's triangles in the overlap
+    BBox3d overlap = isct(desc[0]->box, desc[1]->box);
+    if(isEmpty(overlap))
+        return false;
+    uint probe = (!desc[1]->tri_bvh && desc[0]->tri_bvh)? 1 : 0;
+    const AABVH<uint> *bvh = desc[1-probe]->tri_bvh.get();
+    std::unique_ptr< AABVH<uint> > overlap_bvh;
+    if(!bvh) {
+        std::vector< GeomBlob<uint> > rhs_geoms;
+        for(uint tid=0; tid<rhs.tris.size(); tid++) {
+            if(!hasIsct(desc[1]->tri_boxes[tid], overlap))
+                continue;
+            GeomBlob<uint> blob;
+            blob.id     = tid;
+            blob.bbox   = desc[1]->tri_boxes[tid];
+            blob.point  = (blob.bbox.minp + blob.bbox.maxp) / 2.0;
+            rhs_geoms.push_back(blob);
+        }
+        if(rhs_geoms.size() == 0)
+            return false;
+        overlap_bvh.reset(new AABVH<uint>(rhs_geoms,
+            bvhOptions(mesh->isct_options)));
+        bvh = overlap_bvh.get();
+    }
+    const std::vector<BBox3d> &probe_boxes = desc[probe]->tri_boxes;
+    bool meet = false;
+    for(uint tid=0; tid<probe_boxes.size() && !meet; tid++) {
+        if(!hasIsct(probe_boxes[tid], overlap))
+            continue;
+        bvh->for_each_in_box(probe_boxes[tid], [&](uint) {
+            meet = true;
+        });
+    }
+    if(!meet || !exact)
+        return meet;
+    
+    // Boxes overlap, so test the triangles for real
+    Mesh sub;
+    copyOverlap(rhs, &sub);
+    IsctProblem iproblem(&sub);
+    iproblem.cross_operand_only = true;
+    return iproblem.hasIntersections();
+}
+
+template<class VertData, class TriData>
+void Mesh<VertData,TriData>::BoolProblem::copyOverlap(
+    const Mesh &rhs, Mesh *sub
+) {
+    const Mesh *operands[2] = { mesh, &rhs };
+    
+    OperandCache scratch[2];
+    const OperandCache *desc[2];
+    describeOperands(rhs, false, scratch, desc);
+    BBox3d overlap = paddedOverlap(desc[0]->box, desc[1]->box);
+    
+    sub->isct_options = mesh->isct_options;
+    if(isEmpty(overlap))
+        return;
+    for(uint k=0; k<2; k++) {
+        const Mesh &m = *operands[k];
+        std::vector<uint> vmap(m.verts.size(), INVALID_ID);
+        for(uint tid=0; tid<m.tris.size(); tid++) {
+            if(!hasIsct(desc[k]->tri_boxes[tid], overlap))
+                continue;
+            Tri tri = m.tris[tid];
+            for(uint i=0; i<3; i++) {
+                uint vid = tri.v[i];
+                if(vmap[vid] == INVALID_ID) {
+                    vmap[vid] = sub->verts.size();
+                    sub->verts.push_back(m.verts[vid]);
+                }
+                tri.v[i] = vmap[vid];
+            }
+            tri.data.bool_alg_data = k;
+            sub->tris.push_back(tri);
+        }
+    }
+}
+
+template<class VertData, class TriData>
+typename Mesh<VertData,TriData>::Nesting
+Mesh<VertData,TriData>::BoolProblem::findNesting(const Mesh &rhs)
+{
+    std::vector<bool> inside[2];
+    findContainment(rhs, inside);
+    
+    // does any, or every, triangle of each operand lie inside the other?
+    bool some[2], all[2];
+    for(uint k=0; k<2; k++) {
+        some[k] = std::find(inside[k].begin(), inside[k].end(), true)
+                  != inside[k].end();
+        all[k]  = std::find(inside[k].begin(), inside[k].end(), false)
+                  == inside[k].end();
+    }
+    if(!some[0] && !some[1])
+        return APART;
+    if(all[0] && !some[1])
+        return LHS_IN_RHS;
+    if(all[1] && !some[0])
+        return RHS_IN_LHS;
+    return PARTLY_INSIDE;
+}
+
+template<class VertData, class TriData>
+void Mesh<VertData,TriData>::BoolProblem::findContainment(
+    const Mesh &rhs, std::vector<bool> inside[2]
+) {
+    const Mesh *operands[2] = { mesh, &rhs };
+    
+    OperandCache scratch[2];
+    const OperandCache *desc[2];
+    describeOperands(rhs, true, scratch, desc);
+    
+    for(uint k=0; k<2; k++) {
+        const Mesh &m           = *operands[k];
+        const Mesh &other       = *operands[1-k];
+        const OperandCache &own = *desc[k];
+        inside[k].assign(m.tris.size(), false);
+        
+        // A component can only be inside the other operand if its
+        // box is.  Rays from several components share a BVH
+        std::vector<uint> tests;
+        for(uint comp=0; comp<own.comp_boxes.size(); comp++) {
+            const BBox3d &inner = own.comp_boxes[comp];
+            const BBox3d &outer = desc[1-k]->box;
+            if(isIn(inner.minp, outer) && isIn(inner.maxp, outer))
+                tests.push_back(comp);
+        }
+        const AABVH<uint> *other_bvh = desc[1-k]->tri_bvh.get();
+        std::unique_ptr< AABVH<uint> > built_bvh;
+        if(!other_bvh && tests.size() > 1) {
+            built_bvh = triBVH(other);
+            other_bvh = built_bvh.get();
+        }
+        std::vector<bool> comp_inside(own.comp_boxes.size(), false);
+        for(uint comp : tests)
+            comp_inside[comp] = isInside(m, own.comp_best_tid[comp], other,
+                                         other_bvh);
+        
+        for(uint tid=0; tid<m.tris.size(); tid++)
+            inside[k][tid] = comp_inside[own.comp_of_tri[tid]];
+    }
+}
+
+template<class VertData, class TriData>
+bool Mesh<VertData,TriData>::BoolProblem::doBoolOp(
+    const Mesh &rhs,
+    std::function<TriCode(byte bool_alg_data)> classify
+) {
+    if(surfacesMeet(rhs, false)) {
+        if(!doSetup(rhs))
+            return false;
+        doDeleteAndFlip(classify);
+        return true;
+    }
+    std::vector<bool> inside[2];
+    findContainment(rhs, inside);
+    
+    Timer timer;
+    uint lhs_ntris  = mesh->tris.size();
+    mesh->disjointUnion(rhs);
+    
+    // classify every triangle with the code doSetup() would have
+    // given it, keeping the vertices of the triangles that stay
+    uint nverts = mesh->verts.size();
+    uint ntris  = mesh->tris.size();
+    std::vector<bool> kept(nverts, false);
+    std::vector<bool> dropped(nverts, false);
+    uint write = 0;
+    for(uint tid=0; tid<ntris; tid++) {
+        uint operand = (tid < lhs_ntris)? 0 : 1;
+        uint src_tid = (operand == 0)? tid : tid - lhs_ntris;
+        byte data = operand | (inside[operand][src_tid]? 2 : 0);
+        Tri tri = mesh->tris[tid];
+        TriCode code = classify(data);
+        for(uint k=0; k<3; k++) {
+            if(code == DELETE_TRI)  dropped[tri.v[k]] = true;
+            else                    kept[tri.v[k]] = true;
+        }
+        if(code == DELETE_TRI)
+            continue;
+        if(code == FLIP_TRI)
+            std::swap(tri.v[0], tri.v[1]);
+        mesh->tris[write] = tri;
+        write++;
+    }
+    mesh->tris.resize(write);
+    
+    // remove the vertices only deleted triangles used
+    std::vector<uint> vmap(nverts);
+    uint vwrite = 0;
+    for(uint vid=0; vid<nverts; vid++) {
+        vmap[vid] = vwrite;
+        if(dropped[vid] && !kept[vid])
+            continue;
+        mesh->verts[vwrite] = mesh->verts[vid];
+        vwrite++;
+    }
+    mesh->verts.resize(vwrite);
+    if(vwrite < nverts)
+        for(Tri &tri : mesh->tris)
+            for(uint k=0; k<3; k++)
+                tri.v[k] = vmap[tri.v[k]];
+    mesh->isct_stats.deleteFlipMs += timer.stop();
+    return true;
+}
+
 template<class VertData, class TriData>
 void Mesh<VertData,TriData>::BoolProblem::doDeleteAndFlip(
     std::function<TriCode(byte bool_alg_data)> classify
 ) {
+    Timer timer;
     TopoCache topocache(mesh);
     
     std::vector<Tptr> toDelete;
@@ -287,6 +950,7 @@ void Mesh<VertData,TriData>::BoolProblem::doDeleteAndFlip(
     }
     
     topocache.commit();
+    mesh->isct_stats.deleteFlipMs += timer.stop();
 }
 
 
@@ -294,13 +958,25 @@ void Mesh<VertData,TriData>::BoolProblem::doDeleteAndFlip(
 
 
 template<class VertData, class TriData>
-void Mesh<VertData,TriData>::boolUnion(Mesh &rhs)
+void Mesh<VertData,TriData>::BoolProblem::prepareOperand()
+{
+    std::shared_ptr<OperandCache> desc(new OperandCache());
+    boundOperand(*mesh, desc.get());
+    findComponents(*mesh, desc.get());
+    if(mesh->tris.size() > 0)
+        desc->tri_bvh = triBVH(*mesh);
+    mesh->operand_cache = desc;
+}
+
+
+
+
+template<class VertData, class TriData>
+bool Mesh<VertData,TriData>::boolUnion(const Mesh &rhs)
 {
     BoolProblem bprob(this);
     
-    bprob.doSetup(rhs);
-    
-    bprob.doDeleteAndFlip([](byte data) -> typename BoolProblem::TriCode {
+    return bprob.doBoolOp(rhs, [](byte data) -> typename BoolProblem::TriCode {
         if((data & 2) == 2)     // part of op 0/1 INSIDE op 1/0
             return BoolProblem::DELETE_TRI;
         else                    // part of op 0/1 OUTSIDE op 1/0
@@ -309,13 +985,11 @@ void Mesh<VertData,TriData>::boolUnion(Mesh &rhs)
 }
 
 template<class VertData, class TriData>
-void Mesh<VertData,TriData>::boolDiff(Mesh &rhs)
+bool Mesh<VertData,TriData>::boolDiff(const Mesh &rhs)
 {
     BoolProblem bprob(this);
     
-    bprob.doSetup(rhs);
-    
-    bprob.doDeleteAndFlip([](byte data) -> typename BoolProblem::TriCode {
+    return bprob.doBoolOp(rhs, [](byte data) -> typename BoolProblem::TriCode {
         if(data == 2 ||         // part of op 0 INSIDE op 1
            data == 1)           // part of op 1 OUTSIDE op 0
             return BoolProblem::DELETE_TRI;
@@ -327,13 +1001,11 @@ void Mesh<VertData,TriData>::boolDiff(Mesh &rhs)
 }
 
 template<class VertData, class TriData>
-void Mesh<VertData,TriData>::boolIsct(Mesh &rhs)
+bool Mesh<VertData,TriData>::boolIsct(const Mesh &rhs)
 {
     BoolProblem bprob(this);
     
-    bprob.doSetup(rhs);
-    
-    bprob.doDeleteAndFlip([](byte data) -> typename BoolProblem::TriCode {
+    return bprob.doBoolOp(rhs, [](byte data) -> typename BoolProblem::TriCode {
         if((data & 2) == 0)     // part of op 0/1 OUTSIDE op 1/0
             return BoolProblem::DELETE_TRI;
         else                    // part of op 0/1 INSIDE op 1/0
@@ -342,13 +1014,11 @@ void Mesh<VertData,TriData>::boolIsct(Mesh &rhs)
 }
 
 template<class VertData, class TriData>
-void Mesh<VertData,TriData>::boolXor(Mesh &rhs)
+bool Mesh<VertData,TriData>::boolXor(const Mesh &rhs)
 {
     BoolProblem bprob(this);
     
-    bprob.doSetup(rhs);
-    
-    bprob.doDeleteAndFlip([](byte data) -> typename BoolProblem::TriCode {
+    return bprob.doBoolOp(rhs, [](byte data) -> typename BoolProblem::TriCode {
         if((data & 2) == 0)     // part of op 0/1 OUTSIDE op 1/0
             return BoolProblem::KEEP_TRI;
         else                    // part of op 0/1 INSIDE op 1/0
@@ -356,6 +1026,111 @@ void Mesh<VertData,TriData>::boolXor(Mesh &rhs)
     });
 }
 
+template<class VertData, class TriData>
+bool Mesh<VertData,TriData>::boolNaryUnion(const std::vector<const Mesh*> &rhs)
+{
+    BoolProblem bprob(this);
+    
+    bool resolved = bprob.doNarySetup(rhs,
+    [](uint, std::vector<bool> &inside) -> byte {
+        for(bool in : inside)
+            if(in)  return 2;   // inside some other operand
+        return 0;               // outside all the other operands
+    });
+    if(!resolved)
+        return false;
+    
+    bprob.doDeleteAndFlip([](byte data) -> typename BoolProblem::TriCode {
+        if((data & 2) == 2)     // inside some other operand
+            return BoolProblem::DELETE_TRI;
+        else                    // outside all the other operands
+            return BoolProblem::KEEP_TRI;
+    });
+    return true;
+}
+
+template<class VertData, class TriData>
+void Mesh<VertData,TriData>::prepareBoolOperand()
+{
+    BoolProblem bprob(this);
+    bprob.prepareOperand();
+}
+
+template<class VertData, class TriData>
+bool Mesh<VertData,TriData>::boolIntersects(const Mesh &rhs) const
+{
+    // the problem only reads the mesh
+    BoolProblem bprob(const_cast<Mesh*>(this));
+    
+    return bprob.surfacesMeet(rhs, true);
+}
+
+template<class VertData, class TriData>
+typename Mesh<VertData,TriData>::Nesting
+Mesh<VertData,TriData>::boolNesting(const Mesh &rhs) const
+{
+    // the problem only reads the mesh
+    BoolProblem bprob(const_cast<Mesh*>(this));
+    
+    if(bprob.surfacesMeet(rhs, true))
+        return SURFACES_MEET;
+    return bprob.findNesting(rhs);
+}
+
+template<class VertData, class TriData>
+bool Mesh<VertData,TriData>::isctCurves(
+    const Mesh &rhs, std::vector<IsctCurve> *curves
+) {
+    BoolProblem bprob(this);
+    
+    curves->clear();
+    Mesh sub;
+    bprob.copyOverlap(rhs, &sub);
+    if(sub.tris.size() == 0)
+        return true;
+    
+    IsctProblem iproblem(&sub);
+    iproblem.cross_operand_only = true;
+    bool found = iproblem.findIntersections();
+    if(found)
+        iproblem.dumpIsctCurves(curves);
+    isct_stats.add(sub.isct_stats);
+    return found;
+}
+
+template<class VertData, class TriData>
+bool Mesh<VertData,TriData>::boolNary(
+    const std::vector<const Mesh*> &rhs,
+    std::function<bool(const std::vector<bool> &inside)> contains
+) {
+    BoolProblem bprob(this);
+    
+    // A piece of operand k's surface separates the points just inside
+    // operand k from those just outside it, which agree on every
+    // other operand.  It's part of the result's surface if the two
+    // sides disagree about being in the result.
+    bool resolved = bprob.doNarySetup(rhs,
+    [&](uint operand, std::vector<bool> &inside) -> byte {
+        inside[operand] = true;
+        bool in_behind = contains(inside);
+        inside[operand] = false;
+        bool in_front = contains(inside);
+        if(in_behind == in_front)   // not on the result's boundary
+            return BoolProblem::DELETE_TRI;
+        else if(in_behind)          // facing out of the result
+            return BoolProblem::KEEP_TRI;
+        else                        // facing into the result
+            return BoolProblem::FLIP_TRI;
+    });
+    if(!resolved)
+        return false;
+    
+    bprob.doDeleteAndFlip([](byte data) -> typename BoolProblem::TriCode {
+        return typename BoolProblem::TriCode(data);
+    });
+    return true;
+}
+
 
 
 
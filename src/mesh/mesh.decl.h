@@ -30,6 +30,7 @@
 #include "prelude.h"
 #include <vector>
 #include <set>
+#include <memory>
 
 #include "vec.h"
 #include "ray.h"
@@ -43,6 +44,8 @@ struct BoolVertexData {
 struct BoolTriangleData {
     byte bool_alg_data; // internal use by algorithm
         // please copy value when the triangle is subdivided
+    uint bool_operand;  // internal use by algorithm
+        // please copy value when the triangle is subdivided
 };
 
 
@@ -126,6 +129,72 @@ struct RemeshOptions
     {}
 };
 
+struct IsctOptions
+{
+    uint numThreads;    // threads used to search for intersections;
+                        // 0 means one per hardware thread
+    bool crossOperandOnly;  // in Boolean operations, only look for
+                            // intersections between the two operands.
+                            // Only valid if neither operand is
+                            // self-intersecting (e.g. both are solid)
+    bool overlapOnly;   // in Boolean operations, only resolve triangles
+                        // near the overlap of the operands' bounding
+                        // boxes.  Same validity condition as above
+    bool sahBVH;        // build the BVHs used to find intersections
+                        // and classify triangles with the surface area
+                        // heuristic instead of median splits
+    uint bvhLeafSize;   // maximum number of primitives in a BVH leaf
+    IsctOptions() :
+        numThreads(1),
+        crossOperandOnly(false),
+        overlapOnly(false),
+        sahBVH(false),
+        bvhLeafSize(8)
+    {}
+};
+
+// counters and timings accumulated by the intersection and Boolean
+// operations run on a mesh
+struct IsctStats
+{
+    uint candidatePairs;    // edge-triangle pairs whose boxes overlap
+    uint predicateCalls;    // emptiness tests run on candidates
+    uint ddoubleCalls;      // tests the double filter couldn't decide
+    uint exactCalls;        // tests that fell back to exact arithmetic
+    uint degeneracies;      // degenerate configurations encountered
+    uint perturbRetries;    // times the mesh was perturbed and re-tried
+    uint gluePoints;        // intersection points created
+    uint trisSubdivided;    // triangles split up by intersections
+    double findMs;          // finding intersections (incl. retries)
+    double subdivideMs;     // subdividing and stitching triangles
+    double classifyMs;      // Boolean inside/outside classification
+    double deleteFlipMs;    // Boolean deletion and flipping
+    size_t arenaPeakBytes;  // most intersection scratch memory in use
+    IsctStats() :
+        candidatePairs(0), predicateCalls(0), ddoubleCalls(0),
+        exactCalls(0), degeneracies(0), perturbRetries(0),
+        gluePoints(0), trisSubdivided(0),
+        findMs(0.0), subdivideMs(0.0), classifyMs(0.0), deleteFlipMs(0.0),
+        arenaPeakBytes(0)
+    {}
+    void add(const IsctStats &other) {
+        candidatePairs  += other.candidatePairs;
+        predicateCalls  += other.predicateCalls;
+        ddoubleCalls    += other.ddoubleCalls;
+        exactCalls      += other.exactCalls;
+        degeneracies    += other.degeneracies;
+        perturbRetries  += other.perturbRetries;
+        gluePoints      += other.gluePoints;
+        trisSubdivided  += other.trisSubdivided;
+        findMs          += other.findMs;
+        subdivideMs     += other.subdivideMs;
+        classifyMs      += other.classifyMs;
+        deleteFlipMs    += other.deleteFlipMs;
+        // problems are solved one after another, so peaks don't add up
+        arenaPeakBytes  = std::max(arenaPeakBytes, other.arenaPeakBytes);
+    }
+};
+
 
 // only for internal use, please do not use as client
     struct TopoVert;
@@ -198,8 +267,12 @@ public: // REMESHING module
     RemeshOptions remesh_options;
     
 public: // ISCT (intersections) module
-    void resolveIntersections(); // makes all intersections explicit
+    // makes all intersections explicit.  Returns false, leaving the
+    // mesh as it was, if degeneracies survive every perturbation
+    bool resolveIntersections();
     bool isSelfIntersecting(); // is the mesh self-intersecting?
+    IsctOptions isct_options;
+    IsctStats isct_stats;
     // TESTING
     void testingComputeStaticIsctPoints(std::vector<Vec3d> *points);
     void testingComputeStaticIsct(std::vector<Vec3d> *points,
@@ -208,10 +281,53 @@ public: // ISCT (intersections) module
 public: // BOOLean operation module
     // all of the form
     //      this = this OP rhs
-    void boolUnion(Mesh &rhs);
-    void boolDiff(Mesh &rhs);
-    void boolIsct(Mesh &rhs);
-    void boolXor(Mesh &rhs);
+    // Like resolveIntersections(), each returns false if the
+    // intersections couldn't be resolved; then this mesh holds
+    // no meaningful result
+    bool boolUnion(const Mesh &rhs);
+    bool boolDiff(const Mesh &rhs);
+    bool boolIsct(const Mesh &rhs);
+    bool boolXor(const Mesh &rhs);
+    // this = this OP rhs[0] OP rhs[1] ...
+    // Resolves and classifies all of the operands at once, which is
+    // much faster than folding the binary version over them
+    bool boolNaryUnion(const std::vector<const Mesh*> &rhs);
+    // this = any Boolean function of this, rhs[0], rhs[1] ...
+    // Given whether a point lies inside each operand (this is operand
+    // 0 and rhs[k] is operand k+1), contains tells whether the point
+    // lies inside the result.  Everything is resolved at once, as above
+    bool boolNary(
+        const std::vector<const Mesh*> &rhs,
+        std::function<bool(const std::vector<bool> &inside)> contains
+    );
+    // Bounds this mesh, finds its connected components and builds a
+    // BVH of its triangles once, for the operations above and below
+    // to reuse whenever this mesh is an operand.  Changing the mesh
+    // afterwards, through any of its methods, discards all of that
+    void prepareBoolOperand();
+    // how this and rhs are arranged
+    enum Nesting {
+        SURFACES_MEET,  // the surfaces intersect or touch
+        APART,          // neither contains any part of the other
+        LHS_IN_RHS,     // this lies inside rhs
+        RHS_IN_LHS,     // rhs lies inside this
+        PARTLY_INSIDE   // only some of the connected components of
+                        // this or rhs lie inside the other
+    };
+    // Neither of these changes the meshes or resolves anything.
+    // The search for intersections stops at the first one found
+    bool boolIntersects(const Mesh &rhs) const;
+    Nesting boolNesting(const Mesh &rhs) const;
+    // a curve along which two surfaces intersect
+    struct IsctCurve {
+        std::vector<Vec3d>  points;
+        bool                closed; // the last point joins the first
+    };
+    // Finds the curves along which the surfaces of this and rhs
+    // intersect, without resolving or classifying anything.
+    // Neither mesh changes, apart from this mesh's isct_stats.
+    // Returns false, with no curves, as resolveIntersections() would
+    bool isctCurves(const Mesh &rhs, std::vector<IsctCurve> *curves);
     
 private:    // Internal Formats
     struct Tri {
@@ -236,6 +352,10 @@ private:    // DATA
     std::vector<VertData>   verts;
     
 private:    // caches
+    // see prepareBoolOperand(); shared by copies of the whole mesh
+    struct OperandCache;
+    std::shared_ptr<const OperandCache> operand_cache;
+    
     struct NeighborEntry {
         uint vid;
         ShortVec<uint, 2> tids;
@@ -302,6 +422,9 @@ private:    // Isct Support
         class TriangleProblem; // support type for IsctProblem
         typedef TriangleProblem* Tprob;
         //using Tprob = TriangleProblem*;
+    // like resolveIntersections(), but ignores intersections between
+    // triangles of the same Boolean operand (see bool_alg_data)
+    bool resolveOperandIntersections();
 private:    // Bool Support
     class BoolProblem;
     
@@ -342,6 +465,7 @@ template<class VertData, class TriData>
 inline void Mesh<VertData,TriData>::for_verts(
     std::function<void(VertData &v)> func
 ) {
+    operand_cache.reset();
     for(auto &v : verts)
         func(v);
 }
@@ -350,6 +474,7 @@ template<class VertData, class TriData>
 inline void Mesh<VertData,TriData>::for_tris(
     std::function<void(TriData &, VertData &, VertData &, VertData &)> func
 ) {
+    operand_cache.reset();
     for(auto &tri : tris) {
         auto &a = verts[tri.a];
         auto &b = verts[tri.b];
@@ -364,6 +489,7 @@ inline void Mesh<VertData,TriData>::for_edges(
     std::function<void(TriData &t,
                        VertData &, VertData &, VertData &)> each_tri
 ) {
+    operand_cache.reset();
     NeighborCache cache = createNeighborCache();
     for(uint i=0; i<cache.skeleton.size(); i++) {
         for(auto &entry : cache.skeleton[i]) {
@@ -382,6 +508,7 @@ inline void Mesh<VertData,TriData>::accessIsct(
     const Isct &isct,
     std::function<void(TriData &, VertData &, VertData &, VertData &)> func
 ) {
+    operand_cache.reset();
     Tri &tri = tris[isct.tri_id];
     auto &a = verts[tri.a];
     auto &b = verts[tri.b];
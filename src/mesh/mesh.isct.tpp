@@ -30,8 +30,20 @@
 #include "bbox.h"
 #include "quantization.h"
 #include "empty3d.h"
+#include "smallcdt.h"
 
 #include "aabvh.h"
+#include "parallel.h"
+#include "arena.h"
+
+#include <atomic>
+#include <memory>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <limits>
 
 #define REAL double
 extern "C" {
@@ -128,6 +140,18 @@ struct GluePointMarker
     Tptr                    t[3];
 };
 
+// Storage for the pieces created while subdividing triangle problems.
+// Each worker in IsctProblem::resolveAllIntersections() gets its own,
+// and the edges it replaces are only freed once every worker is done
+struct SubdivideScratch
+{
+    SubdivideScratch() : sepool(arena), gtpool(arena) {}
+    Arena                       arena;
+    ArenaPool<SplitEdgeType>    sepool;
+    ArenaPool<GenericTriType>   gtpool;
+    std::vector<GEptr>          released;
+};
+
 
 
 template<uint LEN> inline
@@ -164,6 +188,13 @@ inline bool hasCommonVert(Tptr t0, Tptr t1)
             t0->verts[2] == t1->verts[2]);
 }
 
+// key for an intersection edge between t and other, as listed in t's
+// triangle problem
+inline uint64_t triPairKey(Tptr t, Tptr other)
+{
+    return (uint64_t(t->ref) << 32) | uint64_t(other->ref);
+}
+
 inline bool hasCommonVert(Eptr e, Tptr t)
 {
     return (e->verts[0] == t->verts[0] ||
@@ -231,11 +262,12 @@ private: // may actually not add edge, but instead just hook up endpoint
         }
     }
 public:
-    // specify reference glue point and edge piercing this triangle.
+    // specify reference glue point and edge piercing this triangle,
+    // along with the already computed point of intersection
     IVptr addInteriorEndpoint(
-        IsctProblem *iprob, Eptr edge, GluePt glue
+        IsctProblem *iprob, Eptr edge, Vec3d coord, GluePt glue
     ) {
-        IVptr       iv              = iprob->newIsctVert(edge, the_tri, glue);
+        IVptr       iv              = iprob->newIsctVert(coord, glue);
                     iv->boundary    = false;
                     iverts.push_back(iv);
         for(Tptr tri_key : edge->tris) {
@@ -256,7 +288,7 @@ public:
     IVptr addBoundaryEndpoint(
         IsctProblem *iprob, Tptr tri_key, Eptr edge, Vec3d coord, GluePt glue
     ) {
-        IVptr       iv              = iprob->newSplitIsctVert(coord, glue);
+        IVptr       iv              = iprob->newIsctVert(coord, glue);
                     addBoundaryHelper(edge, iv);
         // handle edge extending into interior
                     addEdge(iprob, iv, tri_key);
@@ -267,7 +299,7 @@ public:
     IVptr addBoundaryPointAlone(
         IsctProblem *iprob, Eptr edge, Vec3d coord, GluePt glue
     ) {
-        IVptr       iv              = iprob->newSplitIsctVert(coord, glue);
+        IVptr       iv              = iprob->newIsctVert(coord, glue);
                     addBoundaryHelper(edge, iv);
         return iv;
     }
@@ -318,9 +350,13 @@ public:
                         std::cout << iprob->vPos(ie->other_tri_key->verts[k])
                                   << std::endl;
                     std::cout << "degen count:"
-                              << Empty3d::degeneracy_count << std::endl;
+                              << iprob->exact_ctxt.degeneracy_count
+                              << std::endl;
+                    std::cout << "double-double count: "
+                              << iprob->exact_ctxt.ddouble_count
+                              << std::endl;
                     std::cout << "exact count: "
-                              << Empty3d::exact_count << std::endl;
+                              << iprob->exact_ctxt.exact_count << std::endl;
                 }
                 ENSURE(vert); // bad if we can't find a common vertex
                 // then, find the corresponding OVptr, and connect
@@ -343,7 +379,7 @@ public:
         return true;
     }
     
-    void subdivide(IsctProblem *iprob) {
+    void subdivide(IsctProblem *iprob, SubdivideScratch *scratch) {
         // collect all the points, and create more points as necessary
         ShortVec<GVptr, 7> points;
         for(uint k=0; k<3; k++) {
@@ -379,6 +415,21 @@ public:
         for(uint i=0; i<points.size(); i++)
             points[i]->idx = i;
         
+        // tag each point with the original triangle edges it lies on,
+        // so the small triangulator knows which triples are collinear
+        uint lines[SmallCDT::MAX_POINTS];
+        bool small = points.size() <= SmallCDT::MAX_POINTS;
+        if(small) {
+            for(uint i=0; i<points.size(); i++)
+                lines[i] = 0;
+            for(uint k=0; k<3; k++) {
+                lines[oedges[k]->ends[0]->idx] |= 1u << k;
+                lines[oedges[k]->ends[1]->idx] |= 1u << k;
+                for(IVptr iv : oedges[k]->interior)
+                    lines[iv->idx] |= 1u << k;
+            }
+        }
+        
         // split edges and marshall data
         // for safety, we zero out references to pre-subdivided edges,
         // which may have been destroyed
@@ -389,7 +440,7 @@ public:
             //          << oedges[k]->ends[1]->idx << std::endl;
             //for(IVptr iv : oedges[k]->interior)
             //    std::cout << "  " << iv->idx << std::endl;
-            subdivideEdge(iprob, oedges[k], edges);
+            subdivideEdge(iprob, scratch, oedges[k], edges);
             oedges[k]       = nullptr;
         }
         //std::cout << "THE TRI: " << the_tri->verts[0]->ref
@@ -408,7 +459,7 @@ public:
             //    std::cout << "  " << iv->idx 
             //              << " (" << iv->glue_marker->edge_tri_type
             //              << ") " << std::endl;
-            subdivideEdge(iprob, ie, edges);
+            subdivideEdge(iprob, scratch, ie, edges);
             ie              = nullptr;
         }
         for(uint i=0; i<edges.size(); i++)
@@ -423,6 +474,35 @@ public:
         uint dim1 = (normdim+2)%3;
         double sign_flip = (normal.v[normdim] < 0.0)? -1.0 : 1.0;
         
+        // most problems only have a handful of points;
+        // try to triangulate those without going through Triangle
+        if(small && edges.size() <= SmallCDT::MAX_SEGMENTS) {
+            SmallCDT::Input     sin;
+            SmallCDT::Output    sout;
+            sin.numPoints = points.size();
+            for(uint k=0; k<points.size(); k++) {
+                sin.coords[k][0]    = points[k]->coord.v[dim0];
+                sin.coords[k][1]    = points[k]->coord.v[dim1] * sign_flip;
+                sin.lines[k]        = lines[k];
+            }
+            sin.numSegments = edges.size();
+            for(uint k=0; k<edges.size(); k++) {
+                sin.segments[k][0]  = edges[k]->ends[0]->idx;
+                sin.segments[k][1]  = edges[k]->ends[1]->idx;
+            }
+            if(SmallCDT::triangulate(sin, &sout)) {
+                gtris.resize(sout.numTriangles);
+                for(int k=0; k<sout.numTriangles; k++) {
+                    GVptr   gv0     = points[sout.triangles[k][0]];
+                    GVptr   gv1     = points[sout.triangles[k][1]];
+                    GVptr   gv2     = points[sout.triangles[k][2]];
+                            gtris[k] = iprob->newGenericTri(scratch,
+                                                            gv0, gv1, gv2);
+                }
+                return;
+            }
+        }
+        
         struct triangulateio in, out;
         
         /* Define input points. */
@@ -512,7 +592,8 @@ public:
             GVptr       gv0         = points[out.trianglelist[(k*3)+0]];
             GVptr       gv1         = points[out.trianglelist[(k*3)+1]];
             GVptr       gv2         = points[out.trianglelist[(k*3)+2]];
-                        gtris[k]    = iprob->newGenericTri(gv0, gv1, gv2);
+                        gtris[k]    = iprob->newGenericTri(scratch,
+                                                           gv0, gv1, gv2);
         }
         
         
@@ -537,7 +618,8 @@ public:
     }
 
 private:
-    void subdivideEdge(IsctProblem *iprob, GEptr ge, ShortVec<GEptr, 8> &edges)
+    void subdivideEdge(IsctProblem *iprob, SubdivideScratch *scratch,
+                       GEptr ge, ShortVec<GEptr, 8> &edges)
     {
         if(ge->interior.size() == 0) {
             //if(typeid(ge) == typeid(IEptr)) { // generate new edge
@@ -545,10 +627,12 @@ private:
             //}
             edges.push_back(ge);
         } else if(ge->interior.size() == 1) { // common case
-            SEptr       se0     = iprob->newSplitEdge(ge->ends[0],
+            SEptr       se0     = iprob->newSplitEdge(scratch,
+                                                      ge->ends[0],
                                                       ge->interior[0],
                                                       ge->boundary);
-            SEptr       se1     = iprob->newSplitEdge(ge->interior[0],
+            SEptr       se1     = iprob->newSplitEdge(scratch,
+                                                      ge->interior[0],
                                                       ge->ends[1],
                                                       ge->boundary);
                         //iprob->buildConcreteEdge(se0);
@@ -557,7 +641,7 @@ private:
                         edges.push_back(se1);
             
             // get rid of old edge
-                        iprob->releaseEdge(ge);
+                        iprob->releaseEdge(scratch, ge);
         } else { // sorting is the uncommon case
             // determine the primary dimension and direction of the edge
             Vec3d       dir     = ge->ends[1]->coord - ge->ends[0]->coord;
@@ -586,13 +670,14 @@ private:
             
             // now create and accumulate new split edges
             for(uint i=1; i<allv.size(); i++) {
-                SEptr   se      = iprob->newSplitEdge(allv[i-1],
+                SEptr   se      = iprob->newSplitEdge(scratch,
+                                                      allv[i-1],
                                                       allv[i],
                                                       ge->boundary);
                         edges.push_back(se);
             }
             // get rid of old edge
-                        iprob->releaseEdge(ge);
+                        iprob->releaseEdge(scratch, ge);
         }
     }
     
@@ -609,11 +694,30 @@ public: // data
 };
 
 
+struct TriTripleTemp
+{
+    Tptr t0, t1, t2;
+    TriTripleTemp(Tptr tp0, Tptr tp1, Tptr tp2) :
+        t0(tp0), t1(tp1), t2(tp2)
+    {}
+    // the same triple, listed in a canonical order
+    TriTripleTemp sorted() const {
+        Tptr t[3] = { t0, t1, t2 };
+        std::sort(t, t+3);
+        return TriTripleTemp(t[0], t[1], t[2]);
+    }
+    bool operator<(const TriTripleTemp &rhs) const {
+        return std::tie(t0, t1, t2) < std::tie(rhs.t0, rhs.t1, rhs.t2);
+    }
+};
+
 template<class VertData, class TriData>
 class Mesh<VertData,TriData>::IsctProblem : public TopoCache
 {
 public:
-    IsctProblem(Mesh *owner) : TopoCache(owner)
+    IsctProblem(Mesh *owner) : TopoCache(owner), cross_operand_only(false),
+        glue_pts(arena), tprobs(arena),
+        ivpool(arena), ovpool(arena), iepool(arena), oepool(arena)
     {
         // initialize all the triangles to NOT have an associated tprob
         TopoCache::tris.for_each([](Tptr t) {
@@ -625,7 +729,7 @@ public:
         for(VertData &v : TopoCache::mesh->verts) {
             maxMag = std::max(maxMag, max(abs(v.pos)));
         }
-        Quantization::callibrate(maxMag);
+        exact_ctxt.quantizer.callibrate(maxMag);
         
         // and use vertex auxiliary data to store quantized vertex coordinates
         uint N = TopoCache::mesh->verts.size();
@@ -637,12 +741,19 @@ public:
 #else
             Vec3d raw = TopoCache::mesh->verts[v->ref].pos;
 #endif
-            quantized_coords[write].x = Quantization::quantize(raw.x);
-            quantized_coords[write].y = Quantization::quantize(raw.y);
-            quantized_coords[write].z = Quantization::quantize(raw.z);
+            quantized_coords[write].x = exact_ctxt.quantizer.quantize(raw.x);
+            quantized_coords[write].y = exact_ctxt.quantizer.quantize(raw.y);
+            quantized_coords[write].z = exact_ctxt.quantizer.quantize(raw.z);
             v->data = &(quantized_coords[write]);
             write++;
         });
+        
+        // bounds the perturbation; see perturbEpsilon()
+        shortest_edge = std::numeric_limits<double>::infinity();
+        TopoCache::edges.for_each([&](Eptr e) {
+            shortest_edge = std::min(shortest_edge,
+                len(vPos(e->verts[1]) - vPos(e->verts[0])));
+        });
     }
     
     virtual ~IsctProblem() {}
@@ -666,23 +777,16 @@ public:
         return glue;
     }
     
-    inline IVptr newIsctVert(Eptr e, Tptr t, GluePt glue) {
-        IVptr       iv                  = ivpool.alloc();
-                    iv->concrete        = nullptr;
-                    iv->coord           = computeCoords(e, t);
-                    iv->glue_marker     = glue;
-                    glue->copies.push_back(iv);
-        return      iv;
-    }
     inline IVptr newIsctVert(Tptr t0, Tptr t1, Tptr t2, GluePt glue) {
         IVptr       iv                  = ivpool.alloc();
                     iv->concrete        = nullptr;
-                    iv->coord           = computeCoords(t0, t1, t2);
+                    iv->coord           = computeCoords(t0, t1, t2,
+                                                        &exact_ctxt);
                     iv->glue_marker     = glue;
                     glue->copies.push_back(iv);
         return      iv;
     }
-    inline IVptr newSplitIsctVert(Vec3d coords, GluePt glue) {
+    inline IVptr newIsctVert(Vec3d coords, GluePt glue) {
         IVptr       iv                  = ivpool.alloc();
                     iv->concrete        = nullptr;
                     iv->coord           = coords;
@@ -726,8 +830,9 @@ public:
                     v1->edges.push_back(oe);
         return      oe;
     }
-    inline SEptr newSplitEdge(GVptr v0, GVptr v1, bool boundary) {
-        SEptr       se                  = sepool.alloc();
+    inline SEptr newSplitEdge(SubdivideScratch *scratch,
+                              GVptr v0, GVptr v1, bool boundary) {
+        SEptr       se                  = scratch->sepool.alloc();
                     se->concrete        = nullptr;
                     se->boundary        = boundary;
                     se->ends[0]         = v0;
@@ -737,8 +842,9 @@ public:
         return      se;
     }
     
-    inline GTptr newGenericTri(GVptr v0, GVptr v1, GVptr v2) {
-        GTptr       gt                  = gtpool.alloc();
+    inline GTptr newGenericTri(SubdivideScratch *scratch,
+                               GVptr v0, GVptr v1, GVptr v2) {
+        GTptr       gt                  = scratch->gtpool.alloc();
                     gt->verts[0]        = v0;
                     gt->verts[1]        = v1;
                     gt->verts[2]        = v2;
@@ -746,8 +852,12 @@ public:
         return      gt;
     }
     
-    inline void releaseEdge(GEptr ge) {
+    // disconnect the edge now, but leave freeing it for later
+    inline void releaseEdge(SubdivideScratch *scratch, GEptr ge) {
         disconnectGE(ge);
+        scratch->released.push_back(ge);
+    }
+    inline void freeEdge(GEptr ge) {
         IEptr       ie      = dynamic_cast<IEptr>(ge);
         if(ie) {
                     iepool.free(ie);
@@ -804,40 +914,107 @@ public:
         // create edges as necessary...
     }*/
     
-    bool hasIntersections(); // test for iscts, exit if one is found
+    bool hasIntersections(); // test for iscts, exit if one is found;
+                             // only between operands if cross_operand_only
     
-    void findIntersections();
+    // false if perturbing the mesh didn't get rid of the degeneracies
+    // within PERTURB_TRIES tries; then nothing may be resolved
+    bool findIntersections();
     void resolveAllIntersections();
 private:
-    // if we encounter ambiguous degeneracies, then this
-    // routine returns false, indicating that the computation aborted.
-    bool tryToFindIntersections();
+    struct EdgeTriTemp;
+    struct EdgeTriSearch;
+    typedef std::pair<Eptr, Tptr> EdgeTriPair;
+    // find every intersecting edge-triangle pair along with the
+    // point of intersection, by simultaneously traversing triangle and
+    // edge BVHs.  The work is split over
+    // mesh->isct_options.numThreads threads.
+    // Pairs whose test was degenerate are listed in degens instead.
+    // The BVHs are kept in edge_tri_search for refindEdgeTriIscts()
+    void findEdgeTriIscts(std::vector<EdgeTriTemp> &iscts,
+                          std::vector<EdgeTriPair> &degens);
+    // after the vertices of the given edges and triangles have moved,
+    // drop their old results and test them again
+    void refindEdgeTriIscts(const std::vector<Eptr> &moved_edges,
+                            const std::vector<Tptr> &moved_tris,
+                            std::vector<EdgeTriTemp> &iscts,
+                            std::vector<EdgeTriPair> &degens);
+    // run the predicates on candidate (triangle, edge) index pairs
+    void testEdgeTriPairs(
+        const std::vector< std::pair<uint, uint> > &candidates,
+        Empty3d::ExactArithmeticContext *ctxt,
+        std::vector<EdgeTriTemp> &iscts,
+        std::vector<EdgeTriPair> &degens);
+    // build the triangle problems from the edge-triangle intersections
+    // and add the tri-tri-tri intersections.  If we encounter
+    // ambiguous degeneracies, then this routine returns false,
+    // indicating that the computation aborted, and lists the
+    // offending triples in degens.
+    bool tryToFindIntersections(const std::vector<EdgeTriTemp> &iscts,
+                                std::vector<TriTripleTemp> &degens);
     // In that case, we can perturb the positions of points
     void perturbPositions();
+    // or just those of a few vertices, returning the edges and
+    // triangles that moved as a result
+    void perturbVertices(const std::vector<Vptr> &verts,
+                         std::vector<Eptr> &moved_edges,
+                         std::vector<Tptr> &moved_tris);
+    double perturbEpsilon() const;
+    // perturbEpsilon() before it is capped by the shortest edge
+    static double gridEpsilon(const Quantization::Quantizer &quantizer);
     // in order to give things another try, discard partial work
     void reset();
+    // note how much scratch memory is in use in the mesh's stats
+    void recordArenaPeak();
 public:
+    // how many times findIntersections() perturbs the mesh at most
+    static const int PERTURB_TRIES = 5;
+    // how far findIntersections() may move a vertex along any axis,
+    // for a mesh whose coordinates are at most maxMag in magnitude
+    static double perturbBound(double maxMag);
     
     void dumpIsctPoints(std::vector<Vec3d> *points);
     void dumpIsctEdges(std::vector< std::pair<Vec3d,Vec3d> > *edges);
+    // the intersection edges chained into polylines.  A polyline
+    // ends where the curve does or where curves branch
+    void dumpIsctCurves(std::vector<IsctCurve> *curves);
     
+public:
+    // quantization grid and predicate counters for this problem.
+    // Everything the intersection tests depend on lives here or in the
+    // mesh itself, so that separate problems may be solved concurrently
+    Empty3d::ExactArithmeticContext     exact_ctxt;
+    // when set, edges and triangles from the same Boolean operand
+    // (bool_alg_data & 1) are never tested against each other
+    bool                                cross_operand_only;
 protected: // DATA
-    IterPool<GluePointMarker>   glue_pts;
-    IterPool<TriangleProblem>   tprobs;
-    
-    IterPool<IsctVertType>      ivpool;
-    IterPool<OrigVertType>      ovpool;
-    IterPool<IsctEdgeType>      iepool;
-    IterPool<OrigEdgeType>      oepool;
-    IterPool<SplitEdgeType>     sepool;
-    IterPool<GenericTriType>    gtpool;
+    // all of the pieces below are scratch; they live in one arena
+    // that reset() releases in one go
+    Arena                       arena;
+    ArenaPool<GluePointMarker>  glue_pts;
+    ArenaPool<TriangleProblem>  tprobs;
+    
+    ArenaPool<IsctVertType>     ivpool;
+    ArenaPool<OrigVertType>     ovpool;
+    ArenaPool<IsctEdgeType>     iepool;
+    ArenaPool<OrigEdgeType>     oepool;
+    // one per subdivision worker
+    std::vector< std::unique_ptr<SubdivideScratch> >    subdiv_scratch;
 private:
     std::vector<Vec3d>          quantized_coords;
+    double                      shortest_edge; // before perturbation
+    RandomSource                rand_source; // used to perturb positions
+    std::unique_ptr<EdgeTriSearch>  edge_tri_search;
+    // results of tri-tri-tri tests that a retry can reuse
+    std::map<TriTripleTemp, bool>   triple_cache;
 private:
     inline void for_edge_tri(std::function<bool(Eptr e, Tptr t)>);
     inline void bvh_edge_tri(std::function<bool(Eptr e, Tptr t)>);
 
     inline GeomBlob<Eptr> edge_blob(Eptr e);
+    inline uint operand(Tptr t) const {
+        return TopoCache::mesh->tris[t->ref].data.bool_alg_data & 1;
+    }
     inline BBox3d bboxFromTptr(Tptr t);
     
     inline BBox3d buildBox(Eptr e) const;
@@ -850,11 +1027,18 @@ private:
     inline void marshallArithmeticInput(
         Empty3d::TriTriTriIn &input, Tptr t0, Tptr t1, Tptr t2) const;
     
-    bool checkIsct(Eptr e, Tptr t) const;
-    bool checkIsct(Tptr t0, Tptr t1, Tptr t2) const;
+    bool checkIsct(Eptr e, Tptr t,
+                   Empty3d::ExactArithmeticContext *ctxt) const;
+    bool checkIsct(Tptr t0, Tptr t1, Tptr t2,
+                   Empty3d::ExactArithmeticContext *ctxt) const;
+    // for an edge lying in the plane of the triangle, which checkIsct()
+    // only counts as a degeneracy: do the two share a point?
+    bool checkCoplanarIsct(Eptr e, Tptr t) const;
     
-    Vec3d computeCoords(Eptr e, Tptr t) const;
-    Vec3d computeCoords(Tptr t0, Tptr t1, Tptr t2) const;
+    Vec3d computeCoords(Eptr e, Tptr t,
+                        const Empty3d::ExactArithmeticContext *ctxt) const;
+    Vec3d computeCoords(Tptr t0, Tptr t1, Tptr t2,
+                        const Empty3d::ExactArithmeticContext *ctxt) const;
     
     void fillOutVertData(GluePt glue, VertData &data);
     void fillOutTriData(Tptr tri, Tptr parent);
@@ -866,6 +1050,15 @@ private: // functions here to get around a GCC bug...
     void createRealTriangles(Tprob tprob, EdgeCache &ecache);
 };
 
+inline AABVHOptions bvhOptions(const IsctOptions &options)
+{
+    AABVHOptions bvh_opts;
+    bvh_opts.strategy   = (options.sahBVH)? AABVHOptions::BINNED_SAH :
+                                            AABVHOptions::MEDIAN_SPLIT;
+    bvh_opts.leafSize   = options.bvhLeafSize;
+    return bvh_opts;
+}
+
 template<class T, uint LEN> inline
 void for_pairs(
     ShortVec<T,LEN> &vec,
@@ -876,11 +1069,14 @@ void for_pairs(
             func(vec[i], vec[j]);
 }
 
-struct TriTripleTemp
+template<class VertData, class TriData>
+struct Mesh<VertData,TriData>::IsctProblem::EdgeTriTemp
 {
-    Tptr t0, t1, t2;
-    TriTripleTemp(Tptr tp0, Tptr tp1, Tptr tp2) :
-        t0(tp0), t1(tp1), t2(tp2)
+    Eptr e;
+    Tptr t;
+    Vec3d coord;
+    EdgeTriTemp(Eptr ep, Tptr tp, Vec3d p) :
+        e(ep), t(tp), coord(p)
     {}
 };
 
@@ -918,7 +1114,8 @@ void Mesh<VertData,TriData>::IsctProblem::bvh_edge_tri(
     TopoCache::edges.for_each([&](Eptr e) {
         edge_geoms.push_back(edge_blob(e));
     });
-    AABVH<Eptr> edgeBVH(edge_geoms);
+    AABVH<Eptr> edgeBVH(edge_geoms,
+                        bvhOptions(TopoCache::mesh->isct_options));
     
     // use the acceleration structure
     bool aborted = false;
@@ -935,66 +1132,362 @@ void Mesh<VertData,TriData>::IsctProblem::bvh_edge_tri(
 }
 
 template<class VertData, class TriData>
-bool Mesh<VertData,TriData>::IsctProblem::tryToFindIntersections()
+struct Mesh<VertData,TriData>::IsctProblem::EdgeTriSearch
 {
-    Empty3d::degeneracy_count = 0;
-    // Find all edge-triangle intersection points
-    //for_edge_tri([&](Eptr eisct, Tptr tisct)->bool{
-    bvh_edge_tri([&](Eptr eisct, Tptr tisct)->bool{
-      if(checkIsct(eisct,tisct)) {
+    // The hierarchies store indices into the lists of edges and
+    // triangles, alongside which we keep their prepared forms
+    // for the predicates.
+    std::vector<Eptr>                               edge_list;
+    std::vector<Empty3d::PreparedEdge>              edge_preps;
+    std::vector< std::unique_ptr< AABVH<uint> > >   edgeBVHs;
+    std::vector<Tptr>                               tri_list;
+    std::vector<Empty3d::PreparedTri>               tri_preps;
+    std::vector< std::unique_ptr< AABVH<uint> > >   triBVHs;
+    // positions in the lists; only built once a retry needs them
+    std::unordered_map<Eptr, uint>                  edge_index;
+    std::unordered_map<Tptr, uint>                  tri_index;
+    // how far (per coordinate) vertices may have moved since the
+    // hierarchies were built.  Queries pad their boxes by this much.
+    double                                          slack;
+    EdgeTriSearch() : slack(0.0) {}
+};
+
+template<class VertData, class TriData>
+void Mesh<VertData,TriData>::IsctProblem::testEdgeTriPairs(
+    const std::vector< std::pair<uint, uint> > &candidates,
+    Empty3d::ExactArithmeticContext *ctxt,
+    std::vector<EdgeTriTemp> &iscts,
+    std::vector<EdgeTriPair> &degens
+) {
+    const EdgeTriSearch &search = *edge_tri_search;
+    // pairs sharing a vertex trivially intersect only there
+    std::vector< std::pair<uint, uint> >        live;
+    std::vector<const Empty3d::PreparedTri*>    live_tris;
+    std::vector<const Empty3d::PreparedEdge*>   live_edges;
+    live.reserve(candidates.size());
+    live_tris.reserve(candidates.size());
+    live_edges.reserve(candidates.size());
+    for(const std::pair<uint, uint> &cand : candidates) {
+        if(hasCommonVert(search.edge_list[cand.second],
+                         search.tri_list[cand.first]))
+            continue;
+        live.push_back(cand);
+        live_tris.push_back(&search.tri_preps[cand.first]);
+        live_edges.push_back(&search.edge_preps[cand.second]);
+    }
+    if(live.empty())
+        return;
+    
+    std::unique_ptr<bool[]> empty(new bool[live.size()]);
+    int degeneracies = ctxt->degeneracy_count;
+    Empty3d::emptyExactBatch(live.size(), live_tris.data(),
+                             live_edges.data(), empty.get(), ctxt);
+    bool degenerate = ctxt->degeneracy_count > degeneracies;
+    for(uint i=0; i<live.size(); i++) {
+        Tptr t = search.tri_list[live[i].first];
+        Eptr e = search.edge_list[live[i].second];
+        if(degenerate) {
+            // rare, so just find out which pairs were responsible,
+            // using a separate context to avoid counting them twice
+            Empty3d::ExactArithmeticContext probe = *ctxt;
+            probe.resetCounters();
+            Empty3d::emptyExact(*live_tris[i], *live_edges[i], &probe);
+            if(probe.degeneracy_count > 0) {
+                degens.push_back(EdgeTriPair(e, t));
+                continue;
+            }
+        }
+        if(empty[i])    continue;
+        iscts.push_back(EdgeTriTemp(e, t, computeCoords(e, t, ctxt)));
+    }
+}
+
+template<class VertData, class TriData>
+void Mesh<VertData,TriData>::IsctProblem::findEdgeTriIscts(
+    std::vector<EdgeTriTemp> &iscts,
+    std::vector<EdgeTriPair> &degens
+) {
+    // Build hierarchies over the edges and over the triangles.
+    // In cross-operand mode, each operand gets its own pair of BVHs and
+    // each operand's triangles are only paired with the other operand's
+    // edges.  Otherwise, all edges and all triangles go into one BVH each.
+    edge_tri_search.reset(new EdgeTriSearch());
+    EdgeTriSearch &search = *edge_tri_search;
+    uint nBVHs = (cross_operand_only)? 2 : 1;
+    AABVHOptions bvh_opts = bvhOptions(TopoCache::mesh->isct_options);
+    search.edge_preps.resize(TopoCache::edges.size());
+    std::vector< std::vector< GeomBlob<uint> > > edge_geoms(nBVHs);
+    TopoCache::edges.for_each([&](Eptr e) {
+        uint k = (cross_operand_only)? operand(e->tris[0]) : 0;
+        Empty3d::EdgeIn input;
+        marshallArithmeticInput(input, e);
+        Empty3d::prepare(search.edge_preps[search.edge_list.size()], input);
+        GeomBlob<uint> blob;
+        blob.bbox   = buildBox(e);
+        blob.point  = (blob.bbox.minp + blob.bbox.maxp) / 2.0;
+        blob.id     = search.edge_list.size();
+        edge_geoms[k].push_back(blob);
+        search.edge_list.push_back(e);
+    });
+    search.tri_preps.resize(TopoCache::tris.size());
+    std::vector< std::vector< GeomBlob<uint> > > tri_geoms(nBVHs);
+    TopoCache::tris.for_each([&](Tptr t) {
+        uint k = (cross_operand_only)? operand(t) : 0;
+        Empty3d::TriIn input;
+        marshallArithmeticInput(input, t);
+        Empty3d::prepare(search.tri_preps[search.tri_list.size()], input);
+        GeomBlob<uint> blob;
+        blob.bbox   = buildBox(t);
+        blob.point  = (blob.bbox.minp + blob.bbox.maxp) / 2.0;
+        blob.id     = search.tri_list.size();
+        tri_geoms[k].push_back(blob);
+        search.tri_list.push_back(t);
+    });
+    search.edgeBVHs.resize(nBVHs);
+    search.triBVHs.resize(nBVHs);
+    for(uint k=0; k<nBVHs; k++) {
+        if(edge_geoms[k].size() > 0)
+            search.edgeBVHs[k].reset(new AABVH<uint>(edge_geoms[k],
+                                                     bvh_opts));
+        if(tri_geoms[k].size() > 0)
+            search.triBVHs[k].reset(new AABVH<uint>(tri_geoms[k],
+                                                    bvh_opts));
+    }
+    
+    // Split the simultaneous traversal of each (triangle, edge) BVH pair
+    // into independent subtree pairs.  The split doesn't depend on the
+    // number of threads, so neither does the order of the results.
+    struct TraversalTask {
+        uint            tree;   // which triangle BVH
+        AABVHNodePair   nodes;
+    };
+    std::vector<TraversalTask> tasks;
+    for(uint k=0; k<nBVHs; k++) {
+        AABVH<uint> *triBVH  = search.triBVHs[k].get();
+        AABVH<uint> *edgeBVH =
+            search.edgeBVHs[(cross_operand_only)? 1-k : k].get();
+        if(!triBVH || !edgeBVH)
+            continue;
+        std::vector<AABVHNodePair> pairs;
+        triBVH->splitPairs(*edgeBVH, 256, &pairs);
+        for(const AABVHNodePair &np : pairs) {
+            TraversalTask task;
+            task.tree   = k;
+            task.nodes  = np;
+            tasks.push_back(task);
+        }
+    }
+    
+    // Each block of subtree pairs is traversed by its own thread, which
+    // collects candidate pairs into small batches before running the
+    // predicates on them.  The workers only read the (read-only) BVHs
+    // and compute intersection coordinates; they never touch the pools.
+    uint nThreads = TopoCache::mesh->isct_options.numThreads;
+    uint nBlocks  = numBlocks(nThreads, tasks.size());
+    std::vector< std::vector<EdgeTriTemp> > block_iscts(nBlocks);
+    std::vector< std::vector<EdgeTriPair> > block_degens(nBlocks);
+    std::vector<Empty3d::ExactArithmeticContext> block_ctxts(nBlocks,
+                                                             exact_ctxt);
+    std::vector<uint> block_candidates(nBlocks, 0);
+    parallelBlocks(nThreads, tasks.size(),
+    [&](uint block, uint begin, uint end) {
+        Empty3d::ExactArithmeticContext *ctxt = &(block_ctxts[block]);
+        ctxt->resetCounters();
+        const uint BATCH_SIZE = 256;
+        std::vector< std::pair<uint, uint> > batch;
+        batch.reserve(BATCH_SIZE);
+        auto flush = [&]() {
+            block_candidates[block] += batch.size();
+            testEdgeTriPairs(batch, ctxt,
+                             block_iscts[block], block_degens[block]);
+            batch.clear();
+        };
+        for(uint i=begin; i<end; i++) {
+            const TraversalTask &task = tasks[i];
+            AABVH<uint> *triBVH  = search.triBVHs[task.tree].get();
+            AABVH<uint> *edgeBVH = search.edgeBVHs[
+                (cross_operand_only)? 1-task.tree : task.tree].get();
+            triBVH->for_each_overlapping_pair(*edgeBVH,
+            [&](uint t, uint e) {
+                batch.push_back(std::make_pair(t, e));
+                if(batch.size() >= BATCH_SIZE)
+                    flush();
+            }, task.nodes);
+            flush();
+        }
+    });
+    
+    // merge results back in block order, which keeps the output
+    // independent of the number of threads used
+    for(uint b=0; b<nBlocks; b++) {
+        exact_ctxt.addCounters(block_ctxts[b]);
+        TopoCache::mesh->isct_stats.candidatePairs += block_candidates[b];
+        iscts.insert(iscts.end(),
+                     block_iscts[b].begin(), block_iscts[b].end());
+        degens.insert(degens.end(),
+                      block_degens[b].begin(), block_degens[b].end());
+    }
+}
+
+template<class VertData, class TriData>
+void Mesh<VertData,TriData>::IsctProblem::refindEdgeTriIscts(
+    const std::vector<Eptr> &moved_edges,
+    const std::vector<Tptr> &moved_tris,
+    std::vector<EdgeTriTemp> &iscts,
+    std::vector<EdgeTriPair> &degens
+) {
+    EdgeTriSearch &search = *edge_tri_search;
+    if(search.edge_index.empty()) {
+        for(uint i=0; i<search.edge_list.size(); i++)
+            search.edge_index[search.edge_list[i]] = i;
+        for(uint i=0; i<search.tri_list.size(); i++)
+            search.tri_index[search.tri_list[i]] = i;
+    }
+    
+    // forget what we found out about the moved pieces before
+    std::unordered_set<Eptr> edge_moved(moved_edges.begin(),
+                                        moved_edges.end());
+    std::unordered_set<Tptr> tri_moved(moved_tris.begin(),
+                                       moved_tris.end());
+    iscts.erase(std::remove_if(iscts.begin(), iscts.end(),
+        [&](const EdgeTriTemp &isct) {
+            return edge_moved.count(isct.e) > 0 ||
+                   tri_moved.count(isct.t) > 0;
+        }), iscts.end());
+    
+    // The hierarchies still hold the boxes from before any vertex
+    // was moved, so pad the query boxes by the slack.  Pairs of a moved
+    // edge and a moved triangle are only collected from the edge side.
+    Vec3d pad(search.slack, search.slack, search.slack);
+    std::vector< std::pair<uint, uint> > candidates;
+    for(Eptr e : moved_edges) {
+        uint id = search.edge_index[e];
+        Empty3d::EdgeIn input;
+        marshallArithmeticInput(input, e);
+        Empty3d::prepare(search.edge_preps[id], input);
+        uint k = (cross_operand_only)? 1 - operand(e->tris[0]) : 0;
+        AABVH<uint> *triBVH = search.triBVHs[k].get();
+        if(!triBVH)
+            continue;
+        BBox3d box = buildBox(e);
+        box.minp -= pad;
+        box.maxp += pad;
+        triBVH->for_each_in_box(box, [&](uint t) {
+            candidates.push_back(std::make_pair(t, id));
+        });
+    }
+    for(Tptr t : moved_tris) {
+        uint id = search.tri_index[t];
+        Empty3d::TriIn input;
+        marshallArithmeticInput(input, t);
+        Empty3d::prepare(search.tri_preps[id], input);
+        uint k = (cross_operand_only)? 1 - operand(t) : 0;
+        AABVH<uint> *edgeBVH = search.edgeBVHs[k].get();
+        if(!edgeBVH)
+            continue;
+        BBox3d box = buildBox(t);
+        box.minp -= pad;
+        box.maxp += pad;
+        edgeBVH->for_each_in_box(box, [&](uint e) {
+            if(edge_moved.count(search.edge_list[e]) == 0)
+                candidates.push_back(std::make_pair(id, e));
+        });
+    }
+    // re-preparing all moved pieces first keeps the tests consistent
+    TopoCache::mesh->isct_stats.candidatePairs += candidates.size();
+    testEdgeTriPairs(candidates, &exact_ctxt, iscts, degens);
+}
+
+template<class VertData, class TriData>
+bool Mesh<VertData,TriData>::IsctProblem::tryToFindIntersections(
+    const std::vector<EdgeTriTemp> &edge_tri_iscts,
+    std::vector<TriTripleTemp> &degens
+) {
+    for(const EdgeTriTemp &isct : edge_tri_iscts) {
+        Eptr        eisct                   = isct.e;
+        Tptr        tisct                   = isct.t;
         GluePt      glue                    = newGluePt();
                     glue->edge_tri_type     = true;
                     glue->e                 = eisct;
                     glue->t[0]              = tisct;
         // first add point and edges to the pierced triangle
-        IVptr iv = getTprob(tisct)->addInteriorEndpoint(this, eisct, glue);
+        IVptr iv = getTprob(tisct)->addInteriorEndpoint(this, eisct,
+                                                        isct.coord, glue);
         for(Tptr tri : eisct->tris) {
             getTprob(tri)->addBoundaryEndpoint(this, tisct, eisct, iv);
         }
-      }
-      if(Empty3d::degeneracy_count > 0)
-        return false; // break
-      else
-        return true; // continue
-    });
-    if(Empty3d::degeneracy_count > 0) {
-        return false;   // restart / abort
     }
     
     // we're going to peek into the triangle problems in order to
-    // identify potential candidates for Tri-Tri-Tri intersections
-    std::vector<TriTripleTemp> triples;
+    // identify potential candidates for Tri-Tri-Tri intersections.
+    // Index every intersection edge by the pair of triangles it joins,
+    // so that looking for the third edge of a triple is a single lookup
+    std::vector<Tprob> tprob_list;
+    tprob_list.reserve(tprobs.size());
+    std::unordered_map<uint64_t, uint> iedge_counts;
     tprobs.for_each([&](Tprob tprob) {
-        Tptr t0 = tprob->the_tri;
-        // Scan pairs of existing edges to create candidate triples
-        for_pairs<IEptr,2>(tprob->iedges, [&](IEptr &ie1, IEptr &ie2){
-            Tptr t1 = ie1->other_tri_key;
-            Tptr t2 = ie2->other_tri_key;
-            // This triple might be considered three times,
-            // one for each triangle it contains.
-            // To prevent duplication, only proceed if this is
-            // the least triangle according to an arbitrary ordering
-            if(t0 < t1 && t0 < t2) {
-                // now look for the third edge.  We're not
-                // sure if it exists...
-                Tprob prob1 = reinterpret_cast<Tprob>(t1->data);
-                for(IEptr ie : prob1->iedges) {
-                    if(ie->other_tri_key == t2) {
-                        // ADD THE TRIPLE
-                        triples.push_back(TriTripleTemp(t0, t1, t2));
-                    }
+        tprob_list.push_back(tprob);
+        for(IEptr ie : tprob->iedges)
+            iedge_counts[triPairKey(tprob->the_tri, ie->other_tri_key)]++;
+    });
+    // blocks of triangle problems are scanned by separate threads
+    uint nThreads = TopoCache::mesh->isct_options.numThreads;
+    uint nBlocks  = numBlocks(nThreads, tprob_list.size());
+    std::vector< std::vector<TriTripleTemp> > block_triples(nBlocks);
+    parallelBlocks(nThreads, tprob_list.size(),
+    [&](uint block, uint begin, uint end) {
+        for(uint i=begin; i<end; i++) {
+            Tptr t0 = tprob_list[i]->the_tri;
+            // Scan pairs of existing edges to create candidate triples
+            for_pairs<IEptr,2>(tprob_list[i]->iedges,
+            [&](IEptr &ie1, IEptr &ie2) {
+                Tptr t1 = ie1->other_tri_key;
+                Tptr t2 = ie2->other_tri_key;
+                // This triple might be considered three times,
+                // one for each triangle it contains.
+                // To prevent duplication, only proceed if this is
+                // the least triangle according to an arbitrary ordering.
+                // Order by index rather than address, so that the glue
+                // points are created in the same order on every run.
+                if(t0->ref < t1->ref && t0->ref < t2->ref) {
+                    // now look for the third edge.  We're not
+                    // sure if it exists...
+                    auto found = iedge_counts.find(triPairKey(t1, t2));
+                    if(found == iedge_counts.end())
+                        return;
+                    // ADD THE TRIPLE
+                    for(uint n=0; n<found->second; n++)
+                        block_triples[block].push_back(
+                            TriTripleTemp(t0, t1, t2));
                 }
-            }
-        });
+            });
+        }
     });
+    std::vector<TriTripleTemp> triples;
+    for(const std::vector<TriTripleTemp> &block : block_triples)
+        triples.insert(triples.end(), block.begin(), block.end());
     // Now, we've collected a list of Tri-Tri-Tri intersection candidates.
-    // Check to see if the intersections actually exist.
+    // Check to see if the intersections actually exist, reusing the
+    // results from before a retry where none of the triangles moved.
+    // Once a test is degenerate, keep testing to find all the other
+    // degenerate triples, but stop building on the results.
     for(TriTripleTemp t : triples) {
-        if(!checkIsct(t.t0, t.t1, t.t2))    continue;
-        
-        // Abort if we encounter a degeneracy
-        if(Empty3d::degeneracy_count > 0)   break;
-        
+        TriTripleTemp key = t.sorted();
+        auto cached = triple_cache.find(key);
+        bool isct;
+        if(cached != triple_cache.end()) {
+            isct = cached->second;
+        } else {
+            int degeneracies = exact_ctxt.degeneracy_count;
+            isct = checkIsct(t.t0, t.t1, t.t2, &exact_ctxt);
+            if(exact_ctxt.degeneracy_count > degeneracies) {
+                degens.push_back(t);
+                continue;
+            }
+            triple_cache[key] = isct;
+        }
+        if(!isct || !degens.empty())                    continue;
+    
         GluePt      glue                    = newGluePt();
                     glue->edge_tri_type     = false;
                     glue->t[0]              = t.t0;
@@ -1004,25 +1497,93 @@ bool Mesh<VertData,TriData>::IsctProblem::tryToFindIntersections()
         getTprob(t.t1)->addInteriorPoint(this, t.t0, t.t2, glue);
         getTprob(t.t2)->addInteriorPoint(this, t.t0, t.t1, glue);
     }
-    if(Empty3d::degeneracy_count > 0) {
-        return false;   // restart / abort
-    }
     
-    return true;
+    return degens.empty();
+}
+
+template<class VertData, class TriData>
+double Mesh<VertData,TriData>::IsctProblem::perturbEpsilon() const
+{
+    // The perturbation has to span enough grid cells to break up
+    // coplanar contacts, and to keep the intersection points it creates
+    // apart when each triangle is triangulated.  For large coordinates,
+    // a fixed epsilon would round to no perturbation at all and every
+    // retry would run into the same degeneracies.
+    // It also has to stay small next to the mesh's finest features,
+    // e.g. the slivers left by earlier operations; moving their
+    // vertices too far folds them over and leaves holes in the result.
+    const double EDGE_FRACTION  = 0.01;
+    return std::max(1.0e-5, // the original fixed epsilon
+                    std::min(gridEpsilon(exact_ctxt.quantizer),
+                             EDGE_FRACTION * shortest_edge));
+}
+
+template<class VertData, class TriData>
+double Mesh<VertData,TriData>::IsctProblem::gridEpsilon(
+    const Quantization::Quantizer &quantizer
+) {
+    const double MIN_CELLS      = 1024.0;
+    return MIN_CELLS * quantizer.reshrink();
+}
+
+template<class VertData, class TriData>
+double Mesh<VertData,TriData>::IsctProblem::perturbBound(double maxMag)
+{
+    // Every try moves a vertex by at most perturbEpsilon(), which the
+    // shortest edge can only make smaller; quantizing the input moves
+    // it by less than one more grid cell
+    Quantization::Quantizer quantizer;
+    quantizer.callibrate(maxMag);
+    double epsilon = std::max(1.0e-5, gridEpsilon(quantizer));
+    return PERTURB_TRIES * epsilon + quantizer.reshrink();
 }
 
 template<class VertData, class TriData>
 void Mesh<VertData,TriData>::IsctProblem::perturbPositions()
 {
-    const double EPSILON = 1.0e-5; // perturbation epsilon
+    const double EPSILON = perturbEpsilon(); // perturbation epsilon
+    const Quantization::Quantizer &quantizer = exact_ctxt.quantizer;
     for(Vec3d &coord : quantized_coords) {
-        Vec3d perturbation(Quantization::quantize(drand(-EPSILON, EPSILON)),
-                           Quantization::quantize(drand(-EPSILON, EPSILON)),
-                           Quantization::quantize(drand(-EPSILON, EPSILON)));
+        Vec3d perturbation(
+            quantizer.quantize(rand_source.drand(-EPSILON, EPSILON)),
+            quantizer.quantize(rand_source.drand(-EPSILON, EPSILON)),
+            quantizer.quantize(rand_source.drand(-EPSILON, EPSILON)));
         coord += perturbation;
     }
 }
 
+template<class VertData, class TriData>
+void Mesh<VertData,TriData>::IsctProblem::perturbVertices(
+    const std::vector<Vptr> &verts,
+    std::vector<Eptr> &moved_edges,
+    std::vector<Tptr> &moved_tris
+) {
+    const double EPSILON = perturbEpsilon();
+    const Quantization::Quantizer &quantizer = exact_ctxt.quantizer;
+    // vertices may be listed more than once; keep the order of first
+    // appearance, so the perturbation only depends on the input
+    std::unordered_set<Vptr> seen_verts;
+    std::unordered_set<Eptr> seen_edges;
+    std::unordered_set<Tptr> seen_tris;
+    for(Vptr v : verts) {
+        if(!seen_verts.insert(v).second)
+            continue;
+        Vec3d perturbation(
+            quantizer.quantize(rand_source.drand(-EPSILON, EPSILON)),
+            quantizer.quantize(rand_source.drand(-EPSILON, EPSILON)),
+            quantizer.quantize(rand_source.drand(-EPSILON, EPSILON)));
+        *(reinterpret_cast<Vec3d*>(v->data)) += perturbation;
+        for(Eptr e : v->edges)
+            if(seen_edges.insert(e).second)
+                moved_edges.push_back(e);
+        for(Tptr t : v->tris)
+            if(seen_tris.insert(t).second)
+                moved_tris.push_back(t);
+    }
+    if(edge_tri_search)
+        edge_tri_search->slack += EPSILON;
+}
+
 template<class VertData, class TriData>
 void Mesh<VertData,TriData>::IsctProblem::reset()
 {
@@ -1041,58 +1602,141 @@ void Mesh<VertData,TriData>::IsctProblem::reset()
     ovpool.clear();
     iepool.clear();
     oepool.clear();
-    sepool.clear();
-    gtpool.clear();
+    subdiv_scratch.clear();
+    arena.clear();
 }
 
 template<class VertData, class TriData>
-void Mesh<VertData,TriData>::IsctProblem::findIntersections()
+void Mesh<VertData,TriData>::IsctProblem::recordArenaPeak()
 {
-    int nTrys = 5;
+    size_t peak = arena.highWaterBytes();
+    for(auto &scratch : subdiv_scratch)
+        peak += scratch->arena.highWaterBytes();
+    IsctStats &stats = TopoCache::mesh->isct_stats;
+    stats.arenaPeakBytes = std::max(stats.arenaPeakBytes, peak);
+}
+
+template<class VertData, class TriData>
+bool Mesh<VertData,TriData>::IsctProblem::findIntersections()
+{
+    IsctStats &stats = TopoCache::mesh->isct_stats;
+    Timer timer;
     perturbPositions(); // always perturb for safety...
-    while(nTrys > 0) {
-        if(!tryToFindIntersections()) {
+    
+    // Search the whole mesh for edge-triangle intersections once.
+    // When some of the tests are degenerate, only the vertices involved
+    // are perturbed again, and only the pairs near them are re-tested.
+    std::vector<EdgeTriTemp> edge_tri_iscts;
+    std::vector<EdgeTriPair> edge_tri_degens;
+    findEdgeTriIscts(edge_tri_iscts, edge_tri_degens);
+    int nTrys = PERTURB_TRIES;
+    bool found = true;
+    while(true) {
+        std::vector<Vptr> verts;
+        if(edge_tri_degens.empty()) {
+            std::vector<TriTripleTemp> triple_degens;
+            if(tryToFindIntersections(edge_tri_iscts, triple_degens))
+                break;
+            // The triangle problems are rebuilt from the list of
+            // edge-triangle intersections, which is about as much
+            // work as the intersection curves, not the mesh
             reset();
-            perturbPositions();
-            nTrys--;
+            stats.degeneracies += triple_degens.size();
+            for(const TriTripleTemp &t : triple_degens)
+                for(Tptr tri : { t.t0, t.t1, t.t2 })
+                    for(uint k=0; k<3; k++)
+                        verts.push_back(tri->verts[k]);
         } else {
+            stats.degeneracies += edge_tri_degens.size();
+            for(const EdgeTriPair &pair : edge_tri_degens) {
+                for(uint k=0; k<2; k++)
+                    verts.push_back(pair.first->verts[k]);
+                for(uint k=0; k<3; k++)
+                    verts.push_back(pair.second->verts[k]);
+            }
+        }
+        nTrys--;
+        if(nTrys <= 0) {
+            CORK_ERROR("Ran out of tries to perturb the mesh");
+            found = false;
             break;
         }
+        stats.perturbRetries++;
+    
+        std::vector<Eptr> moved_edges;
+        std::vector<Tptr> moved_tris;
+        perturbVertices(verts, moved_edges, moved_tris);
+        std::unordered_set<Tptr> tri_moved(moved_tris.begin(),
+                                           moved_tris.end());
+        for(auto it = triple_cache.begin(); it != triple_cache.end(); ) {
+            const TriTripleTemp &t = it->first;
+            if(tri_moved.count(t.t0) || tri_moved.count(t.t1) ||
+                                        tri_moved.count(t.t2))
+                it = triple_cache.erase(it);
+            else
+                it++;
+        }
+        edge_tri_degens.clear();
+        refindEdgeTriIscts(moved_edges, moved_tris,
+                           edge_tri_iscts, edge_tri_degens);
     }
-    if(nTrys <= 0) {
-        CORK_ERROR("Ran out of tries to perturb the mesh");
-        exit(1);
-    }
+    edge_tri_search.reset();
+    triple_cache.clear();
     
     // ok all points put together,
     // all triangle problems assembled.
     // Some intersection edges may have original vertices as endpoints
     // we consolidate the problems to check for cases like these.
-    tprobs.for_each([&](Tprob tprob) {
-        tprob->consolidate(this);
-    });
+    if(found) {
+        tprobs.for_each([&](Tprob tprob) {
+            tprob->consolidate(this);
+        });
+    }
+    
+    // counters from every try, including the ones that were abandoned
+    stats.predicateCalls    += exact_ctxt.callcount;
+    stats.ddoubleCalls      += exact_ctxt.ddouble_count;
+    stats.exactCalls        += exact_ctxt.exact_count;
+    recordArenaPeak();
+    stats.findMs            += timer.stop();
+    return found;
 }
 
 template<class VertData, class TriData>
 bool Mesh<VertData,TriData>::IsctProblem::hasIntersections()
 {
     bool foundIsct = false;
-    Empty3d::degeneracy_count = 0;
+    bool degenerate = false;
+    exact_ctxt.degeneracy_count = 0;
     // Find some edge-triangle intersection point...
     bvh_edge_tri([&](Eptr eisct, Tptr tisct)->bool{
-      if(checkIsct(eisct,tisct)) {
+      if(cross_operand_only && operand(eisct->tris[0]) == operand(tisct))
+        return true; // continue
+      int degeneracies = exact_ctxt.degeneracy_count;
+      if(checkIsct(eisct, tisct, &exact_ctxt)) {
         foundIsct = true;
         return false; // break;
       }
-      if(Empty3d::degeneracy_count > 0) {
+      if(exact_ctxt.degeneracy_count > degeneracies) {
+        // The edge lies in the triangle's plane.  Between two operands
+        // that's only a contact if the two actually share a point
+        if(cross_operand_only) {
+            if(checkCoplanarIsct(eisct, tisct)) {
+                foundIsct = true;
+                return false; // break;
+            }
+            return true; // continue
+        }
+        degenerate = true;
         return false; // break;
       }
       return true; // continue
     });
     
-    if(Empty3d::degeneracy_count > 0 || foundIsct) {
-        std::cout << "This self-intersection might be spurious. "
-                     "Degeneracies were detected." << std::endl;
+    if(degenerate || foundIsct) {
+        if(!cross_operand_only)
+            std::cout << "This self-intersection might be spurious. "
+                         "Degeneracies were detected." << std::endl;
         return true;
     } else {
         return false;
@@ -1150,8 +1794,10 @@ void Mesh<VertData,TriData>::IsctProblem::marshallArithmeticInput(
 }
 
 template<class VertData, class TriData>
-bool Mesh<VertData,TriData>::IsctProblem::checkIsct(Eptr e, Tptr t) const
-{
+bool Mesh<VertData,TriData>::IsctProblem::checkIsct(
+    Eptr e, Tptr t,
+    Empty3d::ExactArithmeticContext *ctxt
+) const {
     // simple bounding box cull; for acceleration, not correctness
     BBox3d      ebox        = buildBox(e);
     BBox3d      tbox        = buildBox(t);
@@ -1167,13 +1813,23 @@ bool Mesh<VertData,TriData>::IsctProblem::checkIsct(Eptr e, Tptr t) const
     Empty3d::TriEdgeIn input;
     marshallArithmeticInput(input, e, t);
     //bool empty = Empty3d::isEmpty(input);
-    bool empty = Empty3d::emptyExact(input);
+    bool empty = Empty3d::emptyExact(input, ctxt);
     return !empty;
 }
 
+template<class VertData, class TriData>
+bool Mesh<VertData,TriData>::IsctProblem::checkCoplanarIsct(
+    Eptr e, Tptr t
+) const {
+    Empty3d::TriEdgeIn input;
+    marshallArithmeticInput(input, e, t);
+    return !Empty3d::emptyCoplanarExact(input, &exact_ctxt);
+}
+
 template<class VertData, class TriData>
 bool Mesh<VertData,TriData>::IsctProblem::checkIsct(
-    Tptr t0, Tptr t1, Tptr t2
+    Tptr t0, Tptr t1, Tptr t2,
+    Empty3d::ExactArithmeticContext *ctxt
 ) const {
     // This function should only be called if we've already
     // identified that the intersection edges
@@ -1197,26 +1853,29 @@ bool Mesh<VertData,TriData>::IsctProblem::checkIsct(
     Empty3d::TriTriTriIn input;
     marshallArithmeticInput(input, t0, t1, t2);
     //bool empty = Empty3d::isEmpty(input);
-    bool empty = Empty3d::emptyExact(input);
+    bool empty = Empty3d::emptyExact(input, ctxt);
     return !empty;
 }
 
 template<class VertData, class TriData>
-Vec3d Mesh<VertData,TriData>::IsctProblem::computeCoords(Eptr e, Tptr t) const
-{
+Vec3d Mesh<VertData,TriData>::IsctProblem::computeCoords(
+    Eptr e, Tptr t,
+    const Empty3d::ExactArithmeticContext *ctxt
+) const {
     Empty3d::TriEdgeIn input;
     marshallArithmeticInput(input, e, t);
-    Vec3d coords = Empty3d::coordsExact(input);
+    Vec3d coords = Empty3d::coordsExact(input, ctxt);
     return coords;
 }
 
 template<class VertData, class TriData>
 Vec3d Mesh<VertData,TriData>::IsctProblem::computeCoords(
-    Tptr t0, Tptr t1, Tptr t2
+    Tptr t0, Tptr t1, Tptr t2,
+    const Empty3d::ExactArithmeticContext *ctxt
 ) const {
     Empty3d::TriTriTriIn input;
     marshallArithmeticInput(input, t0, t1, t2);
-    Vec3d coords = Empty3d::coordsExact(input);
+    Vec3d coords = Empty3d::coordsExact(input, ctxt);
     return coords;
 }
 
@@ -1397,10 +2056,34 @@ void Mesh<VertData,TriData>::IsctProblem::createRealTriangles(
 template<class VertData, class TriData>
 void Mesh<VertData,TriData>::IsctProblem::resolveAllIntersections()
 {
-    // solve a subdivision problem in each triangle
+    // solve a subdivision problem in each triangle.
+    // The problems only touch their own pieces, so blocks of them are
+    // solved by separate threads, each allocating new pieces from
+    // its own scratch pools.
+    std::vector<Tprob> tprob_list;
+    tprob_list.reserve(tprobs.size());
     tprobs.for_each([&](Tprob tprob) {
-        tprob->subdivide(this);
+        tprob_list.push_back(tprob);
+    });
+    TopoCache::mesh->isct_stats.trisSubdivided += tprob_list.size();
+    uint nThreads = TopoCache::mesh->isct_options.numThreads;
+    uint nBlocks  = numBlocks(nThreads, tprob_list.size());
+    subdiv_scratch.clear();
+    for(uint b=0; b<nBlocks; b++)
+        subdiv_scratch.push_back(
+            std::unique_ptr<SubdivideScratch>(new SubdivideScratch()));
+    parallelBlocks(nThreads, tprob_list.size(),
+    [&](uint block, uint begin, uint end) {
+        SubdivideScratch *scratch = subdiv_scratch[block].get();
+        for(uint i=begin; i<end; i++)
+            tprob_list[i]->subdivide(this, scratch);
     });
+    // with the workers finished, free the edges they replaced
+    for(auto &scratch : subdiv_scratch) {
+        for(GEptr ge : scratch->released)
+            freeEdge(ge);
+        scratch->released.clear();
+    }
     
     // now we have diced up triangles inside each triangle problem
     
@@ -1408,6 +2091,7 @@ void Mesh<VertData,TriData>::IsctProblem::resolveAllIntersections()
     // vertex object for each of these.
     glue_pts.for_each([&](GluePt glue) {
         createRealPtFromGluePt(glue);
+        TopoCache::mesh->isct_stats.gluePoints++;
     });
     
     EdgeCache ecache(this);
@@ -1433,12 +2117,15 @@ void Mesh<VertData,TriData>::IsctProblem::resolveAllIntersections()
         ENSURE(e);
         e->data = (void*)1;
     });
-    sepool.for_each([&](SEptr se) {
-        //if(se->boundary)    return; // continue
-        Eptr e = ecache.maybeEdge(se);
-        ENSURE(e);
-        e->data = (void*)1;
-    });
+    for(auto &scratch : subdiv_scratch) {
+        scratch->sepool.for_each([&](SEptr se) {
+            //if(se->boundary)    return; // continue
+            Eptr e = ecache.maybeEdge(se);
+            ENSURE(e);
+            e->data = (void*)1;
+        });
+    }
+    recordArenaPeak();
     
     // This basically takes care of everything EXCEPT one detail
     // *) The base mesh data structures still need to be compacted
@@ -1474,13 +2161,108 @@ void Mesh<VertData,TriData>::IsctProblem::dumpIsctEdges(
     });
 }
 
+template<class VertData, class TriData>
+void Mesh<VertData,TriData>::IsctProblem::dumpIsctCurves(
+    std::vector<IsctCurve> *curves
+) {
+    curves->clear();
+    
+    // The copies of a point in the different triangle problems share
+    // a glue marker, or are the same original vertex; either way,
+    // that identifies the point.
+    std::unordered_map<const void*, uint> point_ids;
+    std::vector<Vec3d> points;
+    auto pointId = [&](GVptr gv) -> uint {
+        IVptr iv = dynamic_cast<IVptr>(gv);
+        const void *key = (iv)? static_cast<const void*>(iv->glue_marker)
+                              : static_cast<const void*>(gv->concrete);
+        auto found = point_ids.find(key);
+        if(found != point_ids.end())
+            return found->second;
+        uint id = points.size();
+        point_ids[key] = id;
+        points.push_back(gv->coord);
+        return id;
+    };
+    
+    // Each intersection edge shows up in the problems of both of
+    // its triangles, so only take it from the lesser one.  Points
+    // where a third triangle crosses it split it into segments.
+    std::vector< std::pair<uint, uint> > segments;
+    tprobs.for_each([&](Tprob tprob) {
+        for(IEptr ie : tprob->iedges) {
+            if(ie->other_tri_key->ref < tprob->the_tri->ref)
+                continue;
+            Vec3d start = ie->ends[0]->coord;
+            std::vector<IVptr> interior(ie->interior.begin(),
+                                        ie->interior.end());
+            std::sort(interior.begin(), interior.end(),
+            [&](IVptr a, IVptr b) {
+                return len2(a->coord - start) < len2(b->coord - start);
+            });
+            uint prev = pointId(ie->ends[0]);
+            for(IVptr iv : interior) {
+                uint next = pointId(iv);
+                segments.push_back(std::make_pair(prev, next));
+                prev = next;
+            }
+            segments.push_back(std::make_pair(prev, pointId(ie->ends[1])));
+        }
+    });
+    
+    std::vector< std::vector<uint> > point_segs(points.size());
+    for(uint s=0; s<segments.size(); s++) {
+        point_segs[segments[s].first].push_back(s);
+        point_segs[segments[s].second].push_back(s);
+    }
+    
+    // follow the curve from the given point along the given segment,
+    // until it closes or reaches a point that isn't just on the way
+    std::vector<bool> used(segments.size(), false);
+    auto follow = [&](uint first, uint seg) {
+        IsctCurve curve;
+        curve.closed = false;
+        curve.points.push_back(points[first]);
+        uint at = first;
+        while(true) {
+            used[seg] = true;
+            at = (segments[seg].first == at)? segments[seg].second :
+                                              segments[seg].first;
+            if(at == first) {
+                curve.closed = true;
+                break;
+            }
+            curve.points.push_back(points[at]);
+            if(point_segs[at].size() != 2)
+                break;
+            seg = (point_segs[at][0] == seg)? point_segs[at][1] :
+                                              point_segs[at][0];
+        }
+        curves->push_back(curve);
+    };
+    // open curves start at their ends (or branches), and then
+    // whatever is left is a closed loop
+    for(uint p=0; p<points.size(); p++) {
+        if(point_segs[p].size() == 2)
+            continue;
+        for(uint seg : point_segs[p])
+            if(!used[seg])
+                follow(p, seg);
+    }
+    for(uint seg=0; seg<segments.size(); seg++) {
+        if(!used[seg])
+            follow(segments[seg].first, seg);
+    }
+}
+
 template<class VertData, class TriData>
 void Mesh<VertData,TriData>::testingComputeStaticIsctPoints(
     std::vector<Vec3d> *points
 ) {
     IsctProblem iproblem(this);
     
-    iproblem.findIntersections();
+    if(!iproblem.findIntersections())
+        return;
     
     iproblem.dumpIsctPoints(points);
 }
@@ -1493,24 +2275,46 @@ void Mesh<VertData,TriData>::testingComputeStaticIsct(
 ) {
     IsctProblem iproblem(this);
     
-    iproblem.findIntersections();
+    if(!iproblem.findIntersections())
+        return;
     
     iproblem.dumpIsctPoints(points);
     iproblem.dumpIsctEdges(edges);
 }
 
 template<class VertData, class TriData>
-void Mesh<VertData,TriData>::resolveIntersections()
+bool Mesh<VertData,TriData>::resolveIntersections()
 {
     IsctProblem iproblem(this);
     
-    iproblem.findIntersections();
+    if(!iproblem.findIntersections())
+        return false;
     
+    Timer timer;
     iproblem.resolveAllIntersections();
     
     iproblem.commit();
+    isct_stats.subdivideMs += timer.stop();
     
     //iproblem.print();
+    return true;
+}
+
+template<class VertData, class TriData>
+bool Mesh<VertData,TriData>::resolveOperandIntersections()
+{
+    IsctProblem iproblem(this);
+    iproblem.cross_operand_only = true;
+    
+    if(!iproblem.findIntersections())
+        return false;
+    
+    Timer timer;
+    iproblem.resolveAllIntersections();
+    
+    iproblem.commit();
+    isct_stats.subdivideMs += timer.stop();
+    return true;
 }
 
 template<class VertData, class TriData>
@@ -38,7 +38,7 @@ template<class VertData, class TriData>
 Mesh<VertData,TriData>::Mesh() {}
 template<class VertData, class TriData>
 Mesh<VertData,TriData>::Mesh(Mesh &&cp)
-    : tris(cp.tris), verts(cp.verts)
+    : tris(cp.tris), verts(cp.verts), operand_cache(cp.operand_cache)
 {}
 template<class VertData, class TriData>
 Mesh<VertData,TriData>::Mesh(const RawMesh<VertData,TriData> &raw) :
@@ -60,6 +60,7 @@ void Mesh<VertData,TriData>::operator=(Mesh &&src)
 {
     tris = src.tris;
     verts = src.verts;
+    operand_cache = src.operand_cache;
 }
 
 template<class VertData, class TriData>
@@ -112,6 +113,10 @@ RawMesh<VertData,TriData> Mesh<VertData,TriData>::raw() const
 template<class VertData, class TriData>
 void Mesh<VertData,TriData>::disjointUnion(const Mesh &cp)
 {
+    // a copy into an empty mesh is still the operand cp was prepared as
+    operand_cache = (tris.size() == 0 && verts.size() == 0)?
+                    cp.operand_cache : nullptr;
+    
     uint oldVsize = verts.size();
     uint oldTsize = tris.size();
     uint cpVsize  = cp.verts.size();
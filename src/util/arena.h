@@ -0,0 +1,199 @@
+// +-------------------------------------------------------------------------
+// | arena.h
+// | 
+// | Author: Gilbert Bernstein
+// +-------------------------------------------------------------------------
+// | COPYRIGHT:
+// |    Copyright Gilbert Bernstein 2013
+// |    See the included COPYRIGHT file for further details.
+// |    
+// |    This file is part of the Cork library.
+// |
+// |    Cork is free software: you can redistribute it and/or modify
+// |    it under the terms of the GNU Lesser General Public License as
+// |    published by the Free Software Foundation, either version 3 of
+// |    the License, or (at your option) any later version.
+// |
+// |    Cork is distributed in the hope that it will be useful,
+// |    but WITHOUT ANY WARRANTY; without even the implied warranty of
+// |    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// |    GNU Lesser General Public License for more details.
+// |
+// |    You should have received a copy 
+// |    of the GNU Lesser General Public License
+// |    along with Cork.  If not, see <http://www.gnu.org/licenses/>.
+// +-------------------------------------------------------------------------
+#pragma once
+
+#include "prelude.h"
+// +-------------------------------------------------------------------------
+// | WHAT IS THIS?
+// | 
+// | An Arena hands out memory by bumping a pointer through a list of
+// | large chunks.  Nothing is ever given back individually; clear()
+// | releases everything allocated so far at once and keeps the chunks
+// | around, so that the next round of allocation costs nothing.
+// |
+// | An ArenaPool is an IterPool-like front end to an Arena:  items can
+// | be allocated, freed and iterated over (newest first, like IterPool),
+// | but the bookkeeping is a flat array of pointers rather than a linked
+// | list, and freed memory is only reclaimed when the pool is cleared.
+// | This suits scratch data that is built up, used, and then thrown
+// | away wholesale, such as the pieces of an intersection problem.
+// |
+// | Arenas are not thread safe.  Give each thread its own.
+// +-------------------------------------------------------------------------
+
+#include <vector>
+#include <functional>
+#include <type_traits>
+#include <new>
+#include <algorithm>
+
+class Arena
+{
+public:
+    Arena(size_t chunkSize = 64*1024) :
+        chunk_size(chunkSize), current(0), offset(0),
+        in_use(0), high_water(0)
+    {}
+    ~Arena() {
+        for(Chunk &chunk : chunks)
+            delete[] chunk.data;
+    }
+    
+    void* alloc(size_t size, size_t align) {
+        if(chunks.size() > 0) {
+            size_t start = (offset + align - 1) & ~(align - 1);
+            if(start + size <= chunks[current].size)
+                return bump(start, size);
+        }
+        nextChunk(size + align);
+        return bump(0, size);
+    }
+    
+    // release everything at once; the chunks are kept for reuse
+    void clear() {
+        current = 0;
+        offset  = 0;
+        in_use  = 0;
+    }
+    
+    // bytes handed out since the last clear(), incl. alignment padding
+    size_t bytesInUse() const       { return in_use; }
+    // most bytes ever in use at once
+    size_t highWaterBytes() const   { return high_water; }
+    
+private: // seal off copying
+    Arena(const Arena &);
+    Arena& operator=(const Arena &);
+    
+private:
+    struct Chunk {
+        byte   *data;   // new[] aligns this for any fundamental type
+        size_t  size;
+    };
+    
+    void* bump(size_t start, size_t size) {
+        byte *ptr   = chunks[current].data + start;
+        in_use     += start + size - offset;
+        high_water  = std::max(high_water, in_use);
+        offset      = start + size;
+        return ptr;
+    }
+    // move on to a chunk with at least size bytes, making one if needed
+    void nextChunk(size_t size) {
+        uint next = (chunks.size() > 0)? current+1 : 0;
+        if(next >= chunks.size() || chunks[next].size < size) {
+            Chunk chunk;
+            chunk.size = std::max(chunk_size, size);
+            chunk.data = new byte[chunk.size];
+            chunks.insert(chunks.begin() + next, chunk);
+        }
+        current = next;
+        offset  = 0;
+    }
+    
+private:
+    std::vector<Chunk>  chunks;
+    size_t              chunk_size;
+    uint                current;
+    size_t              offset;
+    size_t              in_use;
+    size_t              high_water;
+};
+
+template<class T>
+class ArenaPool
+{
+public:
+    ArenaPool(Arena &mem) : arena(mem), numAlloced(0) {}
+    ~ArenaPool() {
+        destroyAll();
+    }
+    
+    // destroy every item.  The memory is only released along with
+    // the rest of the arena
+    void clear() {
+        destroyAll();
+        slots.clear();
+        numAlloced = 0;
+    }
+    
+private: // seal off copying
+    ArenaPool(const ArenaPool &);
+    ArenaPool& operator=(const ArenaPool &);
+    
+private:
+    struct Slot {
+        T       datum;
+        uint    index; // position in slots
+    };
+    
+public: // allocation/deallocation support
+    T* alloc() {
+        Slot *slot = (Slot*)(arena.alloc(sizeof(Slot), alignof(Slot)));
+        new (&(slot->datum)) T(); // invoke default constructor
+        slot->index = slots.size();
+        slots.push_back(slot);
+        numAlloced++;
+        return (T*)(slot);
+    }
+    void free(T* item) {
+        if(item == NULL)   return;
+        item->~T(); // invoke destructor before releasing
+        
+        numAlloced--;
+        
+        Slot *slot = (Slot*)(item);
+        slots[slot->index] = nullptr;
+    }
+    
+public:
+    // newest items first, in the same order as IterPool
+    inline void for_each(std::function<void(T*)> func) const {
+        for(uint i = slots.size(); i > 0; i--) {
+            if(slots[i-1])
+                func((T*)(slots[i-1]));
+        }
+    }
+    inline uint size() const {
+        return numAlloced;
+    }
+    
+private:
+    void destroyAll() {
+        if(std::is_trivially_destructible<T>::value)
+            return;
+        for(Slot *slot : slots) {
+            if(slot)
+                slot->datum.~T();
+        }
+    }
+    
+private:
+    Arena              &arena;
+    std::vector<Slot*>  slots;
+    uint                numAlloced;
+};
+
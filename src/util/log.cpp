@@ -60,11 +60,9 @@ void logInit()
 // exposes the error log for writing
 std::ostream& err()
 {
-    static bool first = true;
-    if(first) {
-        logInit();
-        first = false;
-    }
+    // initialization of a local static is thread-safe
+    static bool initialized = (logInit(), true);
+    (void)(initialized);
     return error_log_stream;
 }
 
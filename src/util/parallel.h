@@ -0,0 +1,75 @@
+// +-------------------------------------------------------------------------
+// | parallel.h
+// | 
+// | Author: Gilbert Bernstein
+// +-------------------------------------------------------------------------
+// | COPYRIGHT:
+// |    Copyright Gilbert Bernstein 2013
+// |    See the included COPYRIGHT file for further details.
+// |    
+// |    This file is part of the Cork library.
+// |
+// |    Cork is free software: you can redistribute it and/or modify
+// |    it under the terms of the GNU Lesser General Public License as
+// |    published by the Free Software Foundation, either version 3 of
+// |    the License, or (at your option) any later version.
+// |
+// |    Cork is distributed in the hope that it will be useful,
+// |    but WITHOUT ANY WARRANTY; without even the implied warranty of
+// |    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// |    GNU Lesser General Public License for more details.
+// |
+// |    You should have received a copy 
+// |    of the GNU Lesser General Public License
+// |    along with Cork.  If not, see <http://www.gnu.org/licenses/>.
+// +-------------------------------------------------------------------------
+#pragma once
+
+#include "prelude.h"
+
+#include <vector>
+#include <thread>
+#include <functional>
+
+// A requested thread count of 0 means "use every hardware thread"
+inline uint resolveNumThreads(uint requested)
+{
+    if(requested > 0)
+        return requested;
+    uint hw = std::thread::hardware_concurrency();
+    return (hw > 0)? hw : 1;
+}
+
+// number of blocks parallelBlocks() will split N items into
+inline uint numBlocks(uint nThreads, uint N)
+{
+    return std::max(1u, std::min(resolveNumThreads(nThreads), N));
+}
+
+// Split the index range [0,N) into at most nThreads contiguous blocks
+// and run work(block, begin, end) once per block, each on its own thread.
+// The block boundaries depend only on N and the number of blocks, so
+// callers can keep one output buffer per block and concatenate them
+// in block order to get the same result as a serial loop.
+// With a single block, the work runs on the calling thread.
+inline void parallelBlocks(
+    uint nThreads, uint N,
+    std::function<void(uint block, uint begin, uint end)> work
+) {
+    uint nBlocks = numBlocks(nThreads, N);
+    if(nBlocks == 1) {
+        work(0, 0, N);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(nBlocks);
+    for(uint b=0; b<nBlocks; b++) {
+        uint begin  = uint((size_t(N) * b) / nBlocks);
+        uint end    = uint((size_t(N) * (b+1)) / nBlocks);
+        workers.push_back(std::thread(work, b, begin, end));
+    }
+    for(std::thread &worker : workers)
+        worker.join();
+}
+
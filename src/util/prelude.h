@@ -160,5 +160,37 @@ inline uint randMod(uint range) {
     return std::rand()%range;
 }
 
+// The functions above share the global std::rand() state.
+// Library code instead keeps its own RandomSource, so that independent
+// computations may run concurrently and repeat exactly for a given seed.
+class RandomSource {
+public:
+    RandomSource(uint seed = 1) { setSeed(seed); }
+    
+    void setSeed(uint seed) {
+        state = 0x9E3779B97F4A7C15ull * (seed + 1ull);
+        if(state == 0) state = 1; // xorshift must never be seeded with 0
+    }
+    
+    // xorshift64*, returning the high 32 bits
+    uint next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return uint((state * 2685821657736338717ull) >> 32);
+    }
+    
+    double drand(double min, double max) {
+        double rand0to1 = double(next()) / 4294967296.0;
+        return (max-min)*rand0to1 + min;
+    }
+    
+    uint randMod(uint range) {
+        return next()%range;
+    }
+private:
+    unsigned long long state;
+};
+
 
 
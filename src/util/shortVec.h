@@ -26,19 +26,14 @@
 #pragma once
 
 #include "prelude.h"
-#include "memPool.h"
 
 #include <algorithm>
+#include <type_traits>
 
-// Don't know why, but can't get this to compile
-// when I make the datablock def. a member of ShortVec<T,LEN>
-template<class T, uint LEN>
-struct ShortVecBlock_Private {
-    byte data[sizeof(T)*LEN];
-};
-// We allocate these blocks instead of typed arrays
-// in order to ensure that we get control of allocation/deallocation
-// rather than the allocator attempting to do so.
+// Up to LEN entries are stored inline, inside the ShortVec itself.
+// Only longer vectors allocate from the heap.  There is deliberately
+// no shared allocator, so that ShortVecs may be used from
+// several threads at once.
 
 template<class T, uint LEN>
 class ShortVec
@@ -84,26 +79,24 @@ private: // helper functions
     // but not construction/destruction
     void resizeHelper(uint newsize);
     
-public: // shared data structures and data.
-    static MemPool< ShortVecBlock_Private<T,LEN> > pool;
-    
 private: // instance data
     uint user_size;     // actual number of entries from client perspective
-    uint internal_size; // number of entries allocated, if greater than LEN;
-                        // if allocated from the memory pool, this is 0
+    uint internal_size; // number of entries allocated;
+                        // if using the inline storage, this is LEN
     T* data;
+    // We use raw storage instead of a typed array
+    // in order to ensure that we get control of construction/destruction
+    typename std::aligned_storage<sizeof(T)*LEN,
+                                  std::alignment_of<T>::value>::type local;
 };
 
-template<class T, uint LEN>
-MemPool< ShortVecBlock_Private<T,LEN> > ShortVec<T,LEN>::pool;
-
 template<class T, uint LEN> inline
 T* ShortVec<T,LEN>::allocData(uint space, uint &allocated)
 {
     T* result;
     if(space <= LEN) {
         allocated = LEN;
-        result =  reinterpret_cast<T*>(pool.alloc());
+        result =  reinterpret_cast<T*>(&local);
     } else {
         allocated = space;
         result = reinterpret_cast<T*>(new byte[sizeof(T)*space]);
@@ -115,9 +108,7 @@ template<class T, uint LEN> inline
 void ShortVec<T,LEN>::deallocData(T* data_ptr, uint allocated)
 {
     //if(LEN == 2) std::cout << "        Deallocing: " << data_ptr << std::endl;
-    if(allocated <= LEN)
-        pool.free(reinterpret_cast< ShortVecBlock_Private<T,LEN>* >(data_ptr));
-    else
+    if(allocated > LEN)
         delete[] reinterpret_cast<byte*>(data_ptr);
 }
 
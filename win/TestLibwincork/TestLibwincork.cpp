@@ -6,6 +6,10 @@
 #include "..\..\src\cork.h"
 
 #include <iostream>
+#include <vector>
+#include <algorithm>
+#include <map>
+#include <cmath>
 
 void Assert(bool f) {
 	if (!f) {
@@ -14,6 +18,122 @@ void Assert(bool f) {
 	}
 }
 
+// Meshes built in memory for the checks below
+struct TestMesh {
+	std::vector<float> vertices;
+	std::vector<uint> triangles;
+
+	CorkTriMesh corkMesh() {
+		CorkTriMesh mesh;
+		mesh.n_vertices = uint(vertices.size() / 3);
+		mesh.n_triangles = uint(triangles.size() / 3);
+		mesh.vertices = vertices.data();
+		mesh.triangles = triangles.data();
+		return mesh;
+	}
+
+	// adds the box [lo, hi], each face split into n x n squares
+	void addBox(const float lo[3], const float hi[3], int n) {
+		// faces share the vertices along their borders
+		std::map<std::vector<int>, uint> grid;
+		auto vertex = [&](const std::vector<int> &cell) -> uint {
+			auto found = grid.find(cell);
+			if (found != grid.end())
+				return found->second;
+			uint id = uint(vertices.size() / 3);
+			for (int k = 0; k < 3; k++)
+				vertices.push_back(lo[k] + (hi[k] - lo[k]) * cell[k] / n);
+			grid[cell] = id;
+			return id;
+		};
+		for (int axis = 0; axis < 3; axis++) {
+			int u = (axis + 1) % 3;
+			int w = (axis + 2) % 3;
+			for (int side = 0; side < 2; side++) {
+				for (int i = 0; i < n; i++) {
+					for (int j = 0; j < n; j++) {
+						uint corner[2][2];
+						for (int di = 0; di < 2; di++) {
+							for (int dj = 0; dj < 2; dj++) {
+								std::vector<int> cell(3);
+								cell[axis] = side ? n : 0;
+								cell[u] = i + di;
+								cell[w] = j + dj;
+								corner[di][dj] = vertex(cell);
+							}
+						}
+						uint quad[2][3] = {
+							{ corner[0][0], corner[1][0], corner[1][1] },
+							{ corner[0][0], corner[1][1], corner[0][1] } };
+						for (int t = 0; t < 2; t++) {
+							if (!side)
+								std::swap(quad[t][1], quad[t][2]);
+							triangles.insert(triangles.end(), quad[t], quad[t] + 3);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// adds the prism over the counterclockwise triangle xy, from z0 to z1
+	void addPrism(const float xy[3][2], float z0, float z1) {
+		uint first = uint(vertices.size() / 3);
+		for (int side = 0; side < 2; side++) {
+			for (int k = 0; k < 3; k++) {
+				vertices.push_back(xy[k][0]);
+				vertices.push_back(xy[k][1]);
+				vertices.push_back(side ? z1 : z0);
+			}
+		}
+		uint caps[2][3] = { { 0, 2, 1 }, { 3, 4, 5 } };
+		for (int t = 0; t < 2; t++)
+			for (int k = 0; k < 3; k++)
+				triangles.push_back(first + caps[t][k]);
+		for (uint k = 0; k < 3; k++) {
+			uint next = (k + 1) % 3;
+			uint quad[2][3] = { { k, next, next + 3 }, { k, next + 3, k + 3 } };
+			for (int t = 0; t < 2; t++)
+				for (int l = 0; l < 3; l++)
+					triangles.push_back(first + quad[t][l]);
+		}
+	}
+};
+
+double Volume(const CorkTriMesh &mesh) {
+	double volume = 0.0;
+	for (uint t = 0; t < mesh.n_triangles; t++) {
+		const float *a = mesh.vertices + 3 * mesh.triangles[3 * t + 0];
+		const float *b = mesh.vertices + 3 * mesh.triangles[3 * t + 1];
+		const float *c = mesh.vertices + 3 * mesh.triangles[3 * t + 2];
+		volume += (double(a[0]) * (double(b[1]) * c[2] - double(b[2]) * c[1])
+			- double(a[1]) * (double(b[0]) * c[2] - double(b[2]) * c[0])
+			+ double(a[2]) * (double(b[0]) * c[1] - double(b[1]) * c[0])) / 6.0;
+	}
+	return volume;
+}
+
+// every edge is used once in each direction
+bool Closed(const CorkTriMesh &mesh) {
+	std::map<std::pair<uint, uint>, int> edges;
+	for (uint t = 0; t < mesh.n_triangles; t++) {
+		const uint *tri = mesh.triangles + 3 * t;
+		for (int k = 0; k < 3; k++) {
+			edges[std::make_pair(tri[k], tri[(k + 1) % 3])]++;
+			edges[std::make_pair(tri[(k + 1) % 3], tri[k])]--;
+		}
+	}
+	for (auto &edge : edges) {
+		if (edge.second != 0)
+			return false;
+	}
+	return true;
+}
+
+bool Near(double a, double b) {
+	return std::fabs(a - b) < 1.0e-4;
+}
+
 int main()
 {
 	if (!CorkCommander::LoadMesh("ID1", "..\\..\\samples\\ballA.off")) {
@@ -59,6 +179,104 @@ int main()
 	Assert(CorkCommander::SaveMesh("Out2", "difference_moved_and_rotatedY.stl"));
 	std::cout << "RotateY done" << std::endl;
 
+	// A slab crossing a cube, with one face just outside of the cube.
+	// Resolving the intersections perturbs the cube's vertices further
+	// than that, so overlap_only has to resolve that face as well
+	{
+		const float cubeLo[3] = { 0.0f, 0.0f, 0.0f };
+		const float cubeHi[3] = { 1.0f, 1.0f, 1.0f };
+		const float slabLo[3] = { 0.5f, 0.25f, 0.25f };
+		const float slabHi[3] = { 1.000003f, 0.75f, 0.75f };
+		TestMesh cube, slab;
+		cube.addBox(cubeLo, cubeHi, 8);
+		slab.addBox(slabLo, slabHi, 8);
+		CorkOptions options;
+		options.overlap_only = true;
+		CorkTriMesh out;
+		computeUnion(cube.corkMesh(), slab.corkMesh(), &out, options);
+		Assert(Closed(out));
+		Assert(Near(Volume(out), 1.0));
+		freeCorkTriMesh(&out);
+	}
+	std::cout << "Overlap done" << std::endl;
+
+	// Two prisms over disjoint triangles of the same plane.  Their side
+	// faces lie in each other's cap planes without touching, which
+	// mustn't count as the surfaces meeting
+	{
+		const float lowerXY[3][2] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f } };
+		const float upperXY[3][2] = { { 0.0f, 0.2f }, { 0.8f, 1.0f }, { 0.0f, 1.0f } };
+		TestMesh lower, upper;
+		lower.addPrism(lowerXY, 0.0f, 1.0f);
+		upper.addPrism(upperXY, 0.0f, 1.0f);
+		Assert(!intersects(lower.corkMesh(), upper.corkMesh()));
+		Assert(classify(lower.corkMesh(), upper.corkMesh()) == CORK_APART);
+		CorkTriMesh out;
+		Assert(computeUnion(lower.corkMesh(), upper.corkMesh(), &out));
+		Assert(Closed(out) && Near(Volume(out), 0.82));
+		freeCorkTriMesh(&out);
+
+		// and stacked on the same triangle, sharing a cap, they touch
+		TestMesh above;
+		above.addPrism(lowerXY, 1.0f, 2.0f);
+		Assert(intersects(lower.corkMesh(), above.corkMesh()));
+	}
+	std::cout << "Coplanar done" << std::endl;
+
+	// Operands whose surfaces don't meet, one of them with a component
+	// inside the other operand and a component outside of it
+	{
+		const float innerLo[3] = { -0.5f, -0.5f, -0.5f };
+		const float innerHi[3] = { 0.5f, 0.5f, 0.5f };
+		const float farLo[3] = { 9.5f, -0.5f, -0.5f };
+		const float farHi[3] = { 10.5f, 0.5f, 0.5f };
+		const float outerLo[3] = { -1.0f, -1.0f, -1.0f };
+		const float outerHi[3] = { 1.0f, 1.0f, 1.0f };
+		TestMesh parts, outer;
+		parts.addBox(innerLo, innerHi, 2);
+		parts.addBox(farLo, farHi, 2);
+		outer.addBox(outerLo, outerHi, 2);
+		CorkTriMesh out;
+		Assert(computeUnion(parts.corkMesh(), outer.corkMesh(), &out));
+		Assert(Closed(out) && Near(Volume(out), 9.0));
+		freeCorkTriMesh(&out);
+		Assert(computeIntersection(parts.corkMesh(), outer.corkMesh(), &out));
+		Assert(Closed(out) && Near(Volume(out), 1.0));
+		freeCorkTriMesh(&out);
+		Assert(computeDifference(parts.corkMesh(), outer.corkMesh(), &out));
+		Assert(Closed(out) && Near(Volume(out), 1.0));
+		freeCorkTriMesh(&out);
+		Assert(computeDifference(outer.corkMesh(), parts.corkMesh(), &out));
+		Assert(Closed(out) && Near(Volume(out), 7.0));
+		freeCorkTriMesh(&out);
+		Assert(computeSymmetricDifference(parts.corkMesh(), outer.corkMesh(), &out));
+		Assert(Closed(out) && Near(Volume(out), 8.0));
+		freeCorkTriMesh(&out);
+
+		Assert(classify(parts.corkMesh(), outer.corkMesh()) == CORK_PARTLY_INSIDE);
+		Assert(classify(outer.corkMesh(), parts.corkMesh()) == CORK_PARTLY_INSIDE);
+		TestMesh inner;
+		inner.addBox(innerLo, innerHi, 2);
+		Assert(classify(inner.corkMesh(), outer.corkMesh()) == CORK_IN0_IN_IN1);
+		Assert(classify(outer.corkMesh(), inner.corkMesh()) == CORK_IN1_IN_IN0);
+
+		// the same, through prepared operands
+		CorkPreparedMesh *prepared[2] = {
+			prepareCorkMesh(parts.corkMesh()), prepareCorkMesh(outer.corkMesh())
+		};
+		Assert(!intersects(prepared[0], prepared[1]));
+		Assert(classify(prepared[0], prepared[1]) == CORK_PARTLY_INSIDE);
+		Assert(computeDifference(prepared[1], prepared[0], &out));
+		Assert(Closed(out) && Near(Volume(out), 7.0));
+		freeCorkTriMesh(&out);
+		Assert(computeNaryUnion(prepared, 2, &out));
+		Assert(Closed(out) && Near(Volume(out), 9.0));
+		freeCorkTriMesh(&out);
+		freeCorkPreparedMesh(prepared[0]);
+		freeCorkPreparedMesh(prepared[1]);
+	}
+	std::cout << "Components done" << std::endl;
+
 	return 0;
 }
 